@@ -0,0 +1,204 @@
+/********************
+ * FILE: arena.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     A bump allocator for everything belonging to a model. Blocks are
+ *     mapped straight from the system, using huge pages where we can get
+ *     them, and the whole lot is unmapped in one go when the model is freed.
+ */
+
+#include <string.h> /*for memcpy*/
+#include <sys/mman.h> /*for mmap*/
+
+#include "common.h"
+#include "arena.h"
+
+/* every allocation is lined up to this many bytes */
+#define ALIGNMENT 16
+
+/* the smallest block we bother mapping, and the biggest we grow to */
+#define MIN_BLOCK (64 * 1024)
+#define MAX_BLOCK (64 * 1024 * 1024)
+
+/* blocks at least this big are lined up to huge pages */
+#define HUGE_PAGE (2 * 1024 * 1024)
+
+#define ROUND_UP(n,to) (((n) + (to) - 1) / (to) * (to))
+
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+
+/* map_block():
+   description: gets a new block from the system. big blocks are asked for
+                in huge pages first, then as normal pages with a hint that
+                huge pages would be nice
+   inputs: the size of the block wanted (including the header)
+   output: pointer to the block or NULL
+ */
+static arena_block *map_block(size_t size){
+  void *p = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+  if(size >= HUGE_PAGE)
+    p = mmap(NULL,size,PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,-1,0);
+#endif
+
+  if(p == MAP_FAILED) {
+    p = mmap(NULL,size,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,
+             -1,0);
+
+    if(p == MAP_FAILED)
+      return NULL;
+
+#ifdef MADV_HUGEPAGE
+    if(size >= HUGE_PAGE)
+      madvise(p,size,MADV_HUGEPAGE);
+#endif
+  }
+
+  return (arena_block *) p;
+}
+
+
+/* add_block():
+   description: puts a new block at the front of the arena, big enough for
+                at least the given allocation
+   inputs: the arena, the size of the allocation that didn't fit
+   output: false if the system is out of memory
+ */
+static bool add_block(arena *a, size_t size){
+  arena_block *b;
+  size_t header = ROUND_UP(sizeof(arena_block),ALIGNMENT);
+
+  size = ROUND_UP(size + header,MIN_BLOCK);
+  if(size < a->block_size)
+    size = a->block_size;
+  if(size >= HUGE_PAGE)
+    size = ROUND_UP(size,HUGE_PAGE);
+
+  if((b = map_block(size)) == NULL)
+    return false;
+
+  b->next = a->blocks;
+  b->size = size;
+  b->used = header;
+  a->blocks = b;
+  a->reserved += size;
+
+  /* each block is bigger than the last, so there are only ever a few */
+  if(a->block_size < MAX_BLOCK)
+    a->block_size *= 2;
+
+  return true;
+}
+
+
+/* create_arena():
+   description: creates an empty arena
+   inputs: a guess at how much will be allocated from it, or 0
+   output: pointer to the new arena or NULL
+ */
+arena *create_arena(size_t expected){
+  arena temp, *a;
+
+  temp.blocks = NULL;
+  temp.block_size = MIN_BLOCK;
+  temp.last = NULL;
+  temp.reserved = 0;
+  temp.allocated = 0;
+
+  /* the arena itself lives in its first block */
+  if(add_block(&temp,expected + sizeof(arena)) == false)
+    return NULL;
+
+  a = (arena *) ((char *) temp.blocks + temp.blocks->used);
+  temp.blocks->used += ROUND_UP(sizeof(arena),ALIGNMENT);
+  *a = temp;
+
+  return a;
+}
+
+
+/* arena_alloc():
+   description: allocates memory from the arena. there is no way to free
+                it other than freeing the whole arena
+   inputs: the arena, the number of bytes wanted
+   output: pointer to the memory or NULL
+ */
+void *arena_alloc(arena *a,size_t size){
+  arena_block *b;
+  void *p;
+
+  if(a == NULL) return NULL;
+
+  size = ROUND_UP(size,ALIGNMENT);
+
+  b = a->blocks;
+  if(b->used + size > b->size) {
+    if(add_block(a,size) == false)
+      return NULL;
+    b = a->blocks;
+  }
+
+  p = (char *) b + b->used;
+  b->used += size;
+  a->allocated += size;
+  a->last = p;
+
+  return p;
+}
+
+
+/* arena_realloc():
+   description: grows an allocation. if it was the last thing allocated and
+                there is room it is grown where it is, otherwise it is copied
+                somewhere new (and the old space is wasted)
+   inputs: the arena, the old allocation (or NULL), its size, the new size
+   output: pointer to the memory or NULL
+ */
+void *arena_realloc(arena *a,void *p,size_t old_size,size_t size){
+  arena_block *b;
+  void *new_p;
+
+  if(a == NULL) return NULL;
+  if(p == NULL) return arena_alloc(a,size);
+  if(size <= old_size) return p;
+
+  old_size = ROUND_UP(old_size,ALIGNMENT);
+  size = ROUND_UP(size,ALIGNMENT);
+
+  b = a->blocks;
+  if(p == a->last && b->used - old_size + size <= b->size) {
+    b->used += size - old_size;
+    a->allocated += size - old_size;
+    return p;
+  }
+
+  if((new_p = arena_alloc(a,size)) != NULL)
+    memcpy(new_p,p,old_size);
+
+  return new_p;
+}
+
+
+/* free_arena():
+   description: gives all the arena's memory back to the system. the arena
+                itself goes with it
+   inputs: the arena to free
+ */
+void free_arena(arena *a){
+  arena_block *b, *next;
+
+  if(a == NULL) return;
+
+  /* the arena is in the oldest block, so don't touch it once we're going */
+  for(b = a->blocks; b != NULL; b = next){
+    next = b->next;
+    munmap(b,b->size);
+  }
+}
@@ -0,0 +1,48 @@
+/********************
+ * FILE: arena.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for arena.c. Defines the arena structure and contains the
+ *     prototypes for the interface functions
+ */
+
+#ifndef _CB_ARENA_H
+#define _CB_ARENA_H
+
+#include <stddef.h> /*for size_t*/
+
+#include "common.h"
+
+/* a block of memory that allocations are carved out of. the allocations
+   start straight after this header */
+typedef struct arena_block_t {
+  struct arena_block_t *next;
+  size_t size;
+  size_t used;
+} arena_block;
+
+/* arena struct. memory is handed out by bumping a pointer along the
+   current block, and is all given back at once by free_arena() */
+typedef struct arena_t {
+  /* the newest block is first */
+  arena_block *blocks;
+
+  /* how big to make the next block */
+  size_t block_size;
+
+  /* the last allocation, which can be grown in place */
+  void *last;
+
+  /* bytes mapped from the system and bytes handed out */
+  size_t reserved;
+  size_t allocated;
+} arena;
+
+/* interface function prototypes */
+arena *create_arena(size_t);
+void *arena_alloc(arena *,size_t);
+void *arena_realloc(arena *,void *,size_t,size_t);
+void free_arena(arena *);
+#endif /* !_CB_ARENA_H */
@@ -0,0 +1,173 @@
+/********************
+ * FILE: bake.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Functions for moving the colours of an object's faces onto its
+ *     vertices, so faces of different colours can be drawn together. A
+ *     vertex used by faces of more than one colour is split into a copy
+ *     for each colour. Afterwards every face is white, so merging batches
+ *     faces by draw mode alone.
+ */
+
+#include <stdlib.h> /*for malloc*/
+#include <string.h> /*for memcpy*/
+
+#include "common.h"
+#include "arena.h"
+#include "face.h"
+#include "vertex.h"
+#include "object.h"
+#include "bake.h"
+
+/* no colour yet. every real colour has an alpha of 255, so can't be 0 */
+#define NO_COLOUR 0u
+
+/* what vertices no face uses end up */
+#define WHITE 0xffffffffu
+
+
+/* colour_byte():
+   description: a colour channel from 0 to 1 as a byte
+ */
+static unsigned int colour_byte(float c){
+  if(c <= 0) return 0;
+  if(c >= 1) return 255;
+  return (unsigned int) (c * 255.0f + 0.5f);
+}
+
+
+/* pack_colour():
+   description: packs a face's colour into the bytes a vertex stores, in
+                memory order red, green, blue, alpha. alpha is always 255,
+                there's no blending
+ */
+static unsigned int pack_colour(face *f){
+  unsigned char bytes[4];
+  unsigned int packed;
+
+  bytes[0] = colour_byte(f->colour[0]);
+  bytes[1] = colour_byte(f->colour[1]);
+  bytes[2] = colour_byte(f->colour[2]);
+  bytes[3] = 255;
+  memcpy(&packed,bytes,sizeof(packed));
+
+  return packed;
+}
+
+
+/* bake_colours():
+   description: gives every vertex the colour of the faces that use it,
+     splitting vertices used by faces of different colours. the copies go
+     on the end of the vertex array, each one linked from the vertex it
+     came from so later faces of the same colour find it. the new vertex
+     and colour arrays come from the object's arena
+   inputs: an alloced object that has been filled with all the data, where
+           to put what it did
+   output: false if there wasn't enough memory
+ */
+bool bake_colours(object *o, bake_stats *stats){
+  unsigned int *colours, *grown_colours, colour;
+  int *copy, *grown_copy, *indices, *new_indices;
+  unsigned char *new_colours;
+  vertex *vertices, *grown, *new_vertices;
+  int i, j, v, n, size;
+  bool ok = false;
+  face *f;
+
+  stats->vertices_before = stats->vertices_after = o->n_vertices;
+
+  size = o->n_vertices + o->n_vertices / 4 + 16;
+  n = o->n_vertices;
+
+  vertices = (vertex *) malloc(sizeof(vertex) * size);
+  colours = (unsigned int *) malloc(sizeof(unsigned int) * size);
+  copy = (int *) malloc(sizeof(int) * size);
+  new_indices = (int *) malloc(sizeof(int) * (o->n_indices + 1));
+  if(vertices == NULL || colours == NULL || copy == NULL ||
+     new_indices == NULL)
+    goto out;
+
+  /* the object isn't touched until everything has worked */
+  memcpy(new_indices,o->indices,sizeof(int) * o->n_indices);
+
+  memcpy(vertices,o->vertices,sizeof(vertex) * n);
+  for(i = 0; i < n; i++){
+    colours[i] = NO_COLOUR;
+    copy[i] = -1;
+  }
+
+  for(i = 0; i < o->n_faces; i++){
+    f = o->faces + i;
+    colour = pack_colour(f);
+    indices = new_indices + f->first_index;
+
+    for(j = 0; j < f->n_vertices; j++){
+      v = indices[j];
+      if(v < 0 || v >= o->n_vertices) continue;
+
+      if(colours[v] == NO_COLOUR) {
+        colours[v] = colour;
+        continue;
+      }
+
+      while(colours[v] != colour && copy[v] >= 0)
+        v = copy[v];
+
+      if(colours[v] != colour) {
+        if(n == size) {
+          size *= 2;
+          grown = (vertex *) realloc(vertices,sizeof(vertex) * size);
+          if(grown != NULL) vertices = grown;
+          grown_colours = (unsigned int *) realloc(colours,
+                                                   sizeof(unsigned int) * size);
+          if(grown_colours != NULL) colours = grown_colours;
+          grown_copy = (int *) realloc(copy,sizeof(int) * size);
+          if(grown_copy != NULL) copy = grown_copy;
+          if(grown == NULL || grown_colours == NULL || grown_copy == NULL)
+            goto out;
+        }
+
+        vertices[n] = vertices[v];
+        colours[n] = colour;
+        copy[n] = -1;
+        copy[v] = n;
+        v = n++;
+      }
+
+      indices[j] = v;
+    }
+  }
+
+  for(i = 0; i < n; i++)
+    if(colours[i] == NO_COLOUR)
+      colours[i] = WHITE;
+
+  new_vertices = alloc_vertex_array(o->mem,n);
+  new_colours = (unsigned char *) arena_alloc(o->mem,sizeof(unsigned int) * n);
+  if(new_vertices == NULL || new_colours == NULL)
+    goto out;
+
+  memcpy(new_vertices,vertices,sizeof(vertex) * n);
+  memcpy(new_colours,colours,sizeof(unsigned int) * n);
+  memcpy(o->indices,new_indices,sizeof(int) * o->n_indices);
+  o->vertices = new_vertices;
+  o->colours = new_colours;
+  o->n_vertices = o->filled_vertices = n;
+
+  for(i = 0; i < o->n_faces; i++)
+    for(j = 0; j < 4; j++)
+      o->faces[i].colour[j] = 1.0f;
+
+  stats->vertices_after = n;
+  ok = true;
+
+out:
+  free(vertices);
+  free(colours);
+  free(copy);
+  free(new_indices);
+
+  return ok;
+}
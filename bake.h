@@ -0,0 +1,25 @@
+/********************
+ * FILE: bake.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for bake.c. Contains the prototypes for the interface
+ *     functions
+ */
+
+#ifndef _CB_BAKE_H
+#define _CB_BAKE_H
+
+#include "common.h"
+#include "object.h"
+
+/* what bake_colours() did, for printing */
+typedef struct {
+  int vertices_before;
+  int vertices_after;
+} bake_stats;
+
+/* interface function prototypes */
+bool bake_colours(object *,bake_stats *);
+#endif /* !_CB_BAKE_H */
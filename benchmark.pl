@@ -13,15 +13,21 @@ $big_off = "examples/harley.off";
 $runsize = 6;
 
 ## STATISTICS::
-## 24 combinations of parameters
+## 80 combinations of parameters
 ## 6 + 1 runs per parameter
 ## 10 seconds per run
-## 240 * 7 = 1680
-## 1680 seconds per video card per computer
-## 1680s = 28m
+## 800 * 7 = 5600
+## 5600 seconds per video card per computer
+## 5600s = 93m
 
 $fixed_params = "-r x -a 1 -c $seconds_per_run";
-@oparams = ("-o n","-o d","-o v");
+
+# "benchmark.pl --headless" runs everything offscreen, without a display
+if($ARGV[0] eq "--headless") {
+  $fixed_params = "$fixed_params --headless";
+}
+@oparams = ("-o n","-o d","-o v","-o s","-o c","-o h",
+            "-o b","-o m","-o g","-o r");
 @bparams = ("-b","");
 @wparams = ("-w $small_window", "-w $big_window");
 @fparams = ($small_off,$big_off);
@@ -0,0 +1,529 @@
+/********************
+ * FILE: bvh.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Functions for building a bounding volume hierarchy over the triangles
+ *     of an object, so whole parts of it outside the view can be skipped
+ *     with a handful of box tests. Nodes are split with the surface area
+ *     heuristic, binned along the widest axis of the triangles' centres.
+ *     The top of the tree is split on one thread until there's a subtree
+ *     for every worker, then the subtrees are built in parallel on the
+ *     pool and everything is flattened into one depth first node array.
+ */
+
+#include <stdlib.h> /*for malloc, qsort*/
+#include <string.h> /*for memcpy*/
+
+#include "common.h"
+#include "arena.h"
+#include "face.h"
+#include "vertex.h"
+#include "object.h"
+#include "pool.h"
+#include "bvh.h"
+
+/* the number of buckets the centres are sorted into to find a split */
+#define BVH_BINS 16
+
+/* the number of triangles each pool job works out the boxes of */
+#define TRIANGLES_PER_JOB 4096
+
+/* how many subtrees to hand each thread, so the slow ones even out */
+#define TASKS_PER_THREAD 4
+
+/* a triangle being sorted into the tree */
+typedef struct {
+  float min[3];
+  float max[3];
+  float centre[3];
+  int face;
+  int first_index;
+} bvh_triangle;
+
+/* a growing array of nodes */
+typedef struct {
+  bvh_node *nodes;
+  int n_nodes;
+  int size;
+} node_list;
+
+/* a subtree left to build on the pool, over a range of the triangles.
+   each one says if it failed, so the jobs don't share a flag */
+typedef struct {
+  int first;
+  int count;
+  node_list list;
+  bool failed;
+} bvh_task;
+
+/* what the build shares between the jobs */
+typedef struct {
+  object *o;
+  bvh_triangle *tris;
+  int *refs;
+  int n_tris;
+
+  bvh_task *tasks;
+  int n_tasks;
+  int task_depth;
+
+  bool failed;
+} bvh_builder;
+
+
+/* box_area():
+   description: half the surface area of a box, which is all the split
+                costs need
+ */
+static float box_area(float *min, float *max){
+  float x = max[0] - min[0], y = max[1] - min[1], z = max[2] - min[2];
+
+  if(x < 0 || y < 0 || z < 0) return 0;
+  return x * y + y * z + z * x;
+}
+
+
+/* grow_box():
+   description: makes a box big enough to hold another one
+ */
+static void grow_box(float *min, float *max, float *omin, float *omax){
+  int i;
+
+  for(i = 0; i < 3; i++){
+    if(omin[i] < min[i]) min[i] = omin[i];
+    if(omax[i] > max[i]) max[i] = omax[i];
+  }
+}
+
+
+/* empty_box():
+   description: sets a box inside out, so growing it by anything gives that
+ */
+static void empty_box(float *min, float *max){
+  int i;
+
+  for(i = 0; i < 3; i++){
+    min[i] = 1e30f;
+    max[i] = -1e30f;
+  }
+}
+
+
+/* triangles_job():
+   description: pool job working out the boxes and centres of a block of
+                triangles
+ */
+static void triangles_job(void *data, int job){
+  bvh_builder *b = (bvh_builder *) data;
+  int i, j, k, end = (job + 1) * TRIANGLES_PER_JOB;
+  bvh_triangle *t;
+  float p[3];
+  vertex *v;
+
+  if(end > b->n_tris)
+    end = b->n_tris;
+
+  for(i = job * TRIANGLES_PER_JOB; i < end; i++){
+    t = b->tris + i;
+    empty_box(t->min,t->max);
+    for(j = 0; j < 3; j++){
+      v = b->o->vertices + b->o->indices[t->first_index + j];
+      p[0] = v->x; p[1] = v->y; p[2] = v->z;
+      grow_box(t->min,t->max,p,p);
+    }
+    for(k = 0; k < 3; k++)
+      t->centre[k] = (t->min[k] + t->max[k]) * 0.5f;
+  }
+}
+
+
+/* push_node():
+   description: adds a node to the end of a list
+   output: the index of the new node, or -1 if there wasn't enough memory
+ */
+static int push_node(node_list *l){
+  bvh_node *nodes;
+
+  if(l->n_nodes == l->size){
+    l->size = l->size ? l->size * 2 : 64;
+    nodes = (bvh_node *) realloc(l->nodes,sizeof(bvh_node) * l->size);
+    if(nodes == NULL) return -1;
+    l->nodes = nodes;
+  }
+
+  return l->n_nodes++;
+}
+
+
+/* split_triangles():
+   description: sorts a range of triangles into two, at the split with the
+                smallest surface area cost. the centres are binned along
+                the widest axis, and only the bin edges are tried. if the
+                centres are all in the same place the range is just cut in
+                half
+   inputs: the builder, the range, the centres' box
+   output: the number of triangles on the first side
+ */
+static int split_triangles(bvh_builder *b, int first, int count,
+                           float *cmin, float *cmax){
+  float bmin[BVH_BINS][3], bmax[BVH_BINS][3], lmin[3], lmax[3];
+  float rmin[BVH_BINS][3], rmax[BVH_BINS][3], extent, scale, cost, best;
+  int bins[BVH_BINS], axis = 0, i, bin, split = 0, left, tmp;
+  int *refs = b->refs + first;
+  int right[BVH_BINS];
+
+  for(i = 1; i < 3; i++)
+    if(cmax[i] - cmin[i] > cmax[axis] - cmin[axis])
+      axis = i;
+
+  extent = cmax[axis] - cmin[axis];
+  if(extent <= 0) return count / 2;
+
+  scale = BVH_BINS / extent;
+  for(i = 0; i < BVH_BINS; i++){
+    bins[i] = 0;
+    empty_box(bmin[i],bmax[i]);
+  }
+
+  for(i = 0; i < count; i++){
+    bvh_triangle *t = b->tris + refs[i];
+    bin = (int) ((t->centre[axis] - cmin[axis]) * scale);
+    if(bin >= BVH_BINS) bin = BVH_BINS - 1;
+    bins[bin]++;
+    grow_box(bmin[bin],bmax[bin],t->min,t->max);
+  }
+
+  /* sweep from the right to get the boxes of each right hand side, then
+     from the left trying each split */
+  empty_box(lmin,lmax);
+  for(i = BVH_BINS - 1, tmp = 0; i > 0; i--){
+    grow_box(lmin,lmax,bmin[i],bmax[i]);
+    tmp += bins[i];
+    memcpy(rmin[i],lmin,sizeof(lmin));
+    memcpy(rmax[i],lmax,sizeof(lmax));
+    right[i] = tmp;
+  }
+
+  empty_box(lmin,lmax);
+  best = -1;
+  for(i = 1, left = 0; i < BVH_BINS; i++){
+    grow_box(lmin,lmax,bmin[i - 1],bmax[i - 1]);
+    left += bins[i - 1];
+    if(left == 0 || right[i] == 0) continue;
+
+    cost = box_area(lmin,lmax) * left + box_area(rmin[i],rmax[i]) * right[i];
+    if(best < 0 || cost < best){
+      best = cost;
+      split = i;
+    }
+  }
+
+  /* the centres span the bins, so the first and last always have some */
+  if(best < 0) return count / 2;
+
+  /* partition the range around the chosen bin edge */
+  for(i = 0, left = 0; i < count; i++){
+    bin = (int) ((b->tris[refs[i]].centre[axis] - cmin[axis]) * scale);
+    if(bin >= BVH_BINS) bin = BVH_BINS - 1;
+    if(bin < split){
+      tmp = refs[i];
+      refs[i] = refs[left];
+      refs[left++] = tmp;
+    }
+  }
+
+  return left;
+}
+
+
+/* build_node():
+   description: adds the node for a range of triangles to a list, and then
+                its children straight after it. at task_depth the node is
+                left as a placeholder for a subtree built on the pool
+   inputs: the builder, the list, the range, how deep the node is (or -1
+           to build everything)
+   output: false if there wasn't enough memory
+ */
+static bool build_node(bvh_builder *b, node_list *l, int first, int count,
+                       int depth){
+  float cmin[3], cmax[3];
+  bvh_triangle *t;
+  bvh_node *n;
+  int i, node, left;
+
+  node = push_node(l);
+  if(node < 0) return false;
+
+  n = l->nodes + node;
+  empty_box(n->min,n->max);
+  empty_box(cmin,cmax);
+  for(i = first; i < first + count; i++){
+    t = b->tris + b->refs[i];
+    grow_box(n->min,n->max,t->min,t->max);
+    grow_box(cmin,cmax,t->centre,t->centre);
+  }
+
+  if(count <= BVH_LEAF_TRIANGLES) {
+    n->offset = first;
+    n->count = count;
+    return true;
+  }
+
+  if(depth >= 0 && depth == b->task_depth) {
+    b->tasks[b->n_tasks].first = first;
+    b->tasks[b->n_tasks].count = count;
+    n->count = -(++b->n_tasks);
+    return true;
+  }
+
+  n->count = 0;
+  left = split_triangles(b,first,count,cmin,cmax);
+
+  if(build_node(b,l,first,left,depth < 0 ? -1 : depth + 1) == false)
+    return false;
+
+  /* the list may have moved */
+  l->nodes[node].offset = l->n_nodes;
+  return build_node(b,l,first + left,count - left,depth < 0 ? -1 : depth + 1);
+}
+
+
+/* task_job():
+   description: pool job building one of the subtrees
+ */
+static void task_job(void *data, int job){
+  bvh_builder *b = (bvh_builder *) data;
+  bvh_task *task = b->tasks + job;
+
+  task->failed = build_node(b,&task->list,task->first,task->count,-1) ?
+    false : true;
+}
+
+
+/* flatten():
+   description: copies a subtree into the final node array depth first,
+                swapping placeholders for the subtrees built on the pool
+   inputs: the builder, the list the subtree is in, its root, the array
+           and how much of it is filled
+ */
+static void flatten(bvh_builder *b, node_list *l, int i, bvh_node *out,
+                    int *n_out){
+  bvh_node *n = l->nodes + i;
+  int node;
+
+  if(n->count < 0) {
+    flatten(b,&b->tasks[-n->count - 1].list,0,out,n_out);
+    return;
+  }
+
+  node = (*n_out)++;
+  out[node] = *n;
+  if(n->count > 0) return;
+
+  flatten(b,l,i + 1,out,n_out);
+  flatten(b,l,n->offset,out,n_out);
+  out[node].offset = *n_out;
+}
+
+
+/* compare_refs():
+   description: qsort comparison putting triangles back in the order they
+                were in the object
+ */
+static int compare_refs(const void *a, const void *b){
+  return *(const int *) a - *(const int *) b;
+}
+
+
+/* build_bvh():
+   description: builds a hierarchy over the triangles of every
+     GL_TRIANGLES face of the object. each leaf's triangles are put back in
+     the order they were in and grouped into runs by face, so a leaf is
+     drawn with one call per colour it has, and leaves next to each other
+     in the node array are next to each other in the index buffer. the
+     hierarchy comes from the object's arena
+   inputs: an alloced object that has been filled with all the data, the
+           worker pool (or NULL)
+   output: the hierarchy, or NULL if there wasn't enough memory
+ */
+bvh *build_bvh(object *o, pool *workers){
+  bvh_builder b;
+  node_list top;
+  bvh *h;
+  bvh_run *runs;
+  int i, j, k, max_runs, n_indices, threads;
+  face *f;
+
+  if(o == NULL) return NULL;
+
+  memset(&b,0,sizeof(bvh_builder));
+  memset(&top,0,sizeof(node_list));
+  b.o = o;
+
+  for(i = 0, max_runs = 0; i < o->n_faces; i++){
+    f = o->faces + i;
+    if(f->draw_mode == GL_TRIANGLES)
+      b.n_tris += f->n_vertices / 3;
+    else
+      max_runs++;
+  }
+  max_runs += b.n_tris;
+
+  b.tris = (bvh_triangle *) malloc(sizeof(bvh_triangle) * (b.n_tris + 1));
+  b.refs = (int *) malloc(sizeof(int) * (b.n_tris + 1));
+  runs = (bvh_run *) malloc(sizeof(bvh_run) * (max_runs + 1));
+
+  /* one subtree per TASKS_PER_THREAD per thread, to the next power of 2 */
+  threads = workers ? workers->n_threads : 1;
+  for(b.task_depth = 0; (1 << b.task_depth) < threads * TASKS_PER_THREAD;
+      b.task_depth++);
+  if(threads == 1) b.task_depth = -1;
+  b.tasks = (bvh_task *) calloc((1 << (b.task_depth < 0 ? 0 : b.task_depth)),
+                                sizeof(bvh_task));
+
+  h = (bvh *) arena_alloc(o->mem,sizeof(bvh));
+  if(b.tris == NULL || b.refs == NULL || runs == NULL || b.tasks == NULL ||
+     h == NULL) {
+    b.failed = true;
+    goto done;
+  }
+
+  for(i = 0, k = 0; i < o->n_faces; i++){
+    f = o->faces + i;
+    if(f->draw_mode != GL_TRIANGLES) continue;
+    for(j = 0; j + 2 < f->n_vertices; j += 3, k++){
+      b.tris[k].face = i;
+      b.tris[k].first_index = f->first_index + j;
+      b.refs[k] = k;
+    }
+  }
+
+  run_pool(workers,(b.n_tris + TRIANGLES_PER_JOB - 1) / TRIANGLES_PER_JOB,
+           triangles_job,&b);
+
+  h->n_nodes = 0;
+  h->n_leaves = 0;
+  h->n_runs = 0;
+  h->nodes = NULL;
+
+  if(b.n_tris > 0) {
+    if(build_node(&b,&top,0,b.n_tris,b.task_depth < 0 ? -1 : 0) == false) {
+      b.failed = true;
+      goto done;
+    }
+    run_pool(workers,b.n_tasks,task_job,&b);
+    for(i = 0; i < b.n_tasks; i++)
+      if(b.tasks[i].failed)
+        b.failed = true;
+    if(b.failed) goto done;
+
+    h->n_nodes = top.n_nodes - b.n_tasks;
+    for(i = 0; i < b.n_tasks; i++)
+      h->n_nodes += b.tasks[i].list.n_nodes;
+
+    h->nodes = (bvh_node *) arena_alloc(o->mem,sizeof(bvh_node) * h->n_nodes);
+    if(h->nodes == NULL) {
+      b.failed = true;
+      goto done;
+    }
+    i = 0;
+    flatten(&b,&top,0,h->nodes,&i);
+  }
+
+  h->indices = (int *) arena_alloc(o->mem,sizeof(int) * (o->n_indices + 1));
+  if(h->indices == NULL) {
+    b.failed = true;
+    goto done;
+  }
+
+  /* lay the leaves' triangles out in the order the leaves are in */
+  n_indices = 0;
+  for(i = 0; i < h->n_nodes; i++){
+    bvh_node *n = h->nodes + i;
+    if(n->count == 0) continue;
+
+    qsort(b.refs + n->offset,n->count,sizeof(int),compare_refs);
+    for(j = n->offset, k = h->n_runs; j < n->offset + n->count; j++){
+      bvh_triangle *t = b.tris + b.refs[j];
+      if(h->n_runs == k || runs[h->n_runs - 1].face != t->face) {
+        runs[h->n_runs].face = t->face;
+        runs[h->n_runs].first_index = n_indices;
+        runs[h->n_runs++].n_indices = 0;
+      }
+      memcpy(h->indices + n_indices,o->indices + t->first_index,
+             sizeof(int) * 3);
+      n_indices += 3;
+      runs[h->n_runs - 1].n_indices += 3;
+    }
+
+    n->offset = k;
+    n->count = h->n_runs - k;
+    h->n_leaves++;
+  }
+
+  /* then everything that isn't in the tree */
+  h->first_extra = h->n_runs;
+  for(i = 0; i < o->n_faces; i++){
+    f = o->faces + i;
+    if(f->draw_mode == GL_TRIANGLES) continue;
+    runs[h->n_runs].face = i;
+    runs[h->n_runs].first_index = n_indices;
+    runs[h->n_runs++].n_indices = f->n_vertices;
+    memcpy(h->indices + n_indices,o->indices + f->first_index,
+           sizeof(int) * f->n_vertices);
+    n_indices += f->n_vertices;
+  }
+
+  h->runs = (bvh_run *) arena_alloc(o->mem,sizeof(bvh_run) * (h->n_runs + 1));
+  if(h->runs == NULL) {
+    b.failed = true;
+    goto done;
+  }
+  memcpy(h->runs,runs,sizeof(bvh_run) * h->n_runs);
+  h->n_indices = n_indices;
+
+done:
+  free(top.nodes);
+  if(b.tasks != NULL)
+    for(i = 0; i < b.n_tasks; i++)
+      free(b.tasks[i].list.nodes);
+  free(b.tasks);
+  free(b.tris);
+  free(b.refs);
+  free(runs);
+
+  return b.failed ? NULL : h;
+}
+
+
+/* cull_bvh_node():
+   description: checks a node's box against the planes of the view. it's
+                outside if even the corner furthest inside one of the
+                planes is outside it, and inside if the corner least inside
+                each plane is inside them all
+   inputs: the node, the view from setup_cluster_view()
+   output: bvh_outside, bvh_crossing or bvh_inside
+ */
+bvh_cull cull_bvh_node(bvh_node *n, cluster_view *view){
+  bvh_cull cull = bvh_inside;
+  float *p, most, least;
+  int i;
+
+  for(i = 0; i < 6; i++){
+    p = view->planes[i];
+    most = least = p[3];
+    most += p[0] * (p[0] > 0 ? n->max[0] : n->min[0]);
+    most += p[1] * (p[1] > 0 ? n->max[1] : n->min[1]);
+    most += p[2] * (p[2] > 0 ? n->max[2] : n->min[2]);
+    if(most < 0) return bvh_outside;
+
+    least += p[0] * (p[0] > 0 ? n->min[0] : n->max[0]);
+    least += p[1] * (p[1] > 0 ? n->min[1] : n->max[1]);
+    least += p[2] * (p[2] > 0 ? n->min[2] : n->max[2]);
+    if(least < 0) cull = bvh_crossing;
+  }
+
+  return cull;
+}
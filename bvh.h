@@ -0,0 +1,62 @@
+/********************
+ * FILE: bvh.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for bvh.c. Defines the bounding volume hierarchy
+ *     structures and contains the prototypes for the interface functions
+ */
+
+#ifndef _CB_BVH_H
+#define _CB_BVH_H
+
+#include "common.h"
+#include "object.h"
+#include "pool.h"
+#include "cluster.h"
+
+/* nodes with this many triangles or fewer aren't split any more */
+#define BVH_LEAF_TRIANGLES 128
+
+/* a box in the hierarchy. the nodes are stored depth first, so the first
+   child of a node is always the next one along. a node with a count is a
+   leaf, and draws count runs starting at offset. otherwise offset is the
+   node after the end of its subtree, where to carry on if it's culled */
+typedef struct bvh_node_t {
+  float min[3];
+  float max[3];
+  int offset;
+  int count;
+} bvh_node;
+
+/* some of a face's triangles, next to each other in the index buffer */
+typedef struct bvh_run_t {
+  int face;
+  int first_index;
+  int n_indices;
+} bvh_run;
+
+/* bvh struct. the nodes, the runs the leaves draw, and an index buffer in
+   the order of the leaves. faces that aren't GL_TRIANGLES aren't in the
+   hierarchy, their runs come after the leaves' and are always drawn */
+typedef struct bvh_t {
+  bvh_node *nodes;
+  int n_nodes;
+  int n_leaves;
+
+  bvh_run *runs;
+  int n_runs;
+  int first_extra;
+
+  int *indices;
+  int n_indices;
+} bvh;
+
+/* what a box test found */
+typedef enum { bvh_outside, bvh_crossing, bvh_inside } bvh_cull;
+
+/* interface function prototypes */
+bvh *build_bvh(object *,pool *);
+bvh_cull cull_bvh_node(bvh_node *,cluster_view *);
+#endif /* !_CB_BVH_H */
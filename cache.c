@@ -0,0 +1,404 @@
+/********************
+ * FILE: cache.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Functions for the binary geometry cache. Once a .off file has been
+ *     read, the object is written out next to it (harley.off -> harley.offc)
+ *     and on later runs the cache is memory mapped and the object pointed
+ *     straight at it, so nothing needs to be parsed. The levels of detail
+ *     made from a model are cached in the same way (harley.offl).
+ */
+
+#include <stdio.h>
+#include <stdlib.h> /*for malloc*/
+#include <string.h> /*for memcmp*/
+#include <fcntl.h> /*for open*/
+#include <unistd.h> /*for close*/
+#include <sys/mman.h> /*for mmap*/
+#include <sys/stat.h> /*for stat*/
+
+#include "common.h"
+#include "arena.h"
+#include "face.h"
+#include "vertex.h"
+#include "object.h"
+#include "cache.h"
+
+#define CACHE_MAGIC "OFFC"
+#define LOD_CACHE_MAGIC "OFFL"
+#define BYTE_ORDER_MARK 0x01020304
+
+/* cache_name():
+   description: works out the name of a cache file for a .off file
+   inputs: the .off filename, what goes on the end
+   output: a malloced string, or NULL
+ */
+static char *cache_name(const char *filename, const char *suffix){
+  char *name;
+
+  name = (char *) malloc(strlen(filename) + strlen(suffix) + 1);
+  if(name == NULL) return NULL;
+
+  strcpy(name,filename);
+  strcat(name,suffix);
+
+  return name;
+}
+
+
+/* mtime_nsec():
+   description: gets the part of a file's modification time under a second
+   inputs: the file's details
+   output: the nanoseconds
+ */
+static long long mtime_nsec(struct stat *source){
+#ifdef __APPLE__
+  return source->st_mtimespec.tv_nsec;
+#else
+  return source->st_mtim.tv_nsec;
+#endif
+}
+
+
+/* fill_header():
+   description: sets up a header for the given source file and object
+   inputs: the header to fill, the .off file's details, the object
+ */
+static void fill_header(cache_header *h, struct stat *source, object *o){
+  memset(h,0,sizeof(cache_header));
+  memcpy(h->magic,CACHE_MAGIC,4);
+  h->version = CACHE_VERSION;
+  h->byte_order = BYTE_ORDER_MARK;
+  h->vertex_size = sizeof(vertex);
+  h->face_size = sizeof(face);
+  h->source_size = source->st_size;
+  h->source_mtime = source->st_mtime;
+  h->source_mtime_nsec = mtime_nsec(source);
+
+  if(o == NULL) return;
+
+  h->n_vertices = o->filled_vertices;
+  h->n_faces = o->filled_faces;
+  h->n_indices = o->n_indices;
+}
+
+
+/* load_cache():
+   description: tries to load the object from the cache of a .off file
+   inputs: the object to fill, the .off filename
+   output: true if the cache was there and up to date
+ */
+bool load_cache(object *o, const char *filename){
+  struct stat source, info;
+  cache_header expected, *h;
+  char *name, *data;
+  face *faces;
+  int fd, i, *indices;
+  size_t size;
+
+  if(o == NULL || stat(filename,&source) < 0) return false;
+  if((name = cache_name(filename,CACHE_SUFFIX)) == NULL) return false;
+
+  fd = open(name,O_RDONLY);
+  free(name);
+  if(fd < 0) return false;
+
+  if(fstat(fd,&info) < 0 || info.st_size < sizeof(cache_header)) {
+    close(fd);
+    return false;
+  }
+
+  /* map it privately, so we can still change the object without touching
+     the file */
+  data = mmap(NULL,info.st_size,PROT_READ | PROT_WRITE,MAP_PRIVATE,fd,0);
+  close(fd);
+  if(data == MAP_FAILED) return false;
+
+  /* make sure this is a cache for the file as it is now */
+  h = (cache_header *) data;
+  fill_header(&expected,&source,NULL);
+
+  size = sizeof(cache_header) + sizeof(vertex) * (size_t) h->n_vertices +
+         sizeof(face) * (size_t) h->n_faces +
+         sizeof(int) * (size_t) h->n_indices;
+
+  if(memcmp(h->magic,expected.magic,4) != 0 ||
+     h->version != expected.version ||
+     h->byte_order != expected.byte_order ||
+     h->vertex_size != expected.vertex_size ||
+     h->face_size != expected.face_size ||
+     h->source_size != expected.source_size ||
+     h->source_mtime != expected.source_mtime ||
+     h->source_mtime_nsec != expected.source_mtime_nsec ||
+     h->n_vertices < 0 || h->n_faces < 0 || h->n_indices < 0 ||
+     size != info.st_size) {
+    munmap(data,info.st_size);
+    return false;
+  }
+
+  /* don't trust the file to point anywhere it shouldn't */
+  faces = (face *) ((vertex *) (h + 1) + h->n_vertices);
+  indices = (int *) (faces + h->n_faces);
+
+  for(i = 0; i < h->n_faces; i++)
+    if(faces[i].first_index < 0 || faces[i].n_vertices < 0 ||
+       faces[i].n_vertices > h->n_indices - faces[i].first_index) {
+      munmap(data,info.st_size);
+      return false;
+    }
+
+  for(i = 0; i < h->n_indices; i++)
+    if(indices[i] < 0 || indices[i] >= h->n_vertices) {
+      munmap(data,info.st_size);
+      return false;
+    }
+
+  /* point the object at the vertices, faces and indices in the file */
+  o->n_vertices = o->filled_vertices = h->n_vertices;
+  o->n_faces = o->filled_faces = h->n_faces;
+  o->n_indices = o->index_capacity = h->n_indices;
+  o->vertices = (vertex *) (h + 1);
+  o->faces = (face *) (o->vertices + h->n_vertices);
+  o->indices = (int *) (o->faces + h->n_faces);
+  o->map = data;
+  o->map_size = info.st_size;
+  o->lods = NULL;
+  o->n_lods = 0;
+  o->qvertices = NULL;
+  o->colours = NULL;
+
+  /* nothing needs allocating yet, but anything that changes the object
+     later will want an arena */
+  if((o->mem = create_arena(0)) == NULL) {
+    munmap(data,info.st_size);
+    return false;
+  }
+
+  return true;
+}
+
+
+/* save_cache():
+   description: writes the object out to the cache for a .off file. the
+                file is written under a temporary name and moved into place
+                so nobody ever sees half a cache
+   inputs: the object to save, the .off filename
+   output: true if the cache was written
+ */
+bool save_cache(object *o, const char *filename){
+  struct stat source;
+  cache_header h;
+  char *name, *temp;
+  FILE *file;
+  bool ok = true;
+
+  if(o == NULL || stat(filename,&source) < 0) return false;
+  if((name = cache_name(filename,CACHE_SUFFIX)) == NULL) return false;
+
+  temp = (char *) malloc(strlen(name) + 32);
+  if(temp == NULL) {
+    free(name);
+    return false;
+  }
+  sprintf(temp,"%s.%ld",name,(long) getpid());
+
+  if((file = fopen(temp,"wb")) == NULL) {
+    free(temp);
+    free(name);
+    return false;
+  }
+
+  fill_header(&h,&source,o);
+
+  if(fwrite(&h,sizeof(h),1,file) != 1 ||
+     fwrite(o->vertices,sizeof(vertex),h.n_vertices,file) != h.n_vertices ||
+     fwrite(o->faces,sizeof(face),h.n_faces,file) != h.n_faces ||
+     fwrite(o->indices,sizeof(int),h.n_indices,file) != h.n_indices)
+    ok = false;
+
+  if(fclose(file) != 0)
+    ok = false;
+
+  if(ok == false || rename(temp,name) != 0) {
+    unlink(temp);
+    ok = false;
+  }
+
+  free(temp);
+  free(name);
+
+  return ok;
+}
+
+
+/* fill_lod_header():
+   description: sets up a level of detail cache header
+   inputs: the header to fill, the .off file's details, the object, the key
+ */
+static void fill_lod_header(lod_cache_header *h, struct stat *source,
+                            object *o, unsigned int key){
+  memset(h,0,sizeof(lod_cache_header));
+  memcpy(h->magic,LOD_CACHE_MAGIC,4);
+  h->version = LOD_CACHE_VERSION;
+  h->byte_order = BYTE_ORDER_MARK;
+  h->face_size = sizeof(face);
+  h->source_size = source->st_size;
+  h->source_mtime = source->st_mtime;
+  h->source_mtime_nsec = mtime_nsec(source);
+  h->key = key;
+  h->n_vertices = o->n_vertices;
+  h->n_faces = o->n_faces;
+  h->n_indices = o->n_indices;
+  h->n_lods = o->n_lods;
+}
+
+
+/* load_lod_cache():
+   description: tries to load the levels of detail for an object from their
+                cache. they're read into the object's arena
+   inputs: the object, the .off filename, a key for the passes the object
+           went through after it was loaded
+   output: true if the cache was there and up to date
+ */
+bool load_lod_cache(object *o, const char *filename, unsigned int key){
+  lod_cache_header expected, h;
+  struct stat source;
+  int counts[2], i, j;
+  FILE *file;
+  char *name;
+  lod *lods;
+
+  if(o == NULL || stat(filename,&source) < 0) return false;
+  if((name = cache_name(filename,LOD_CACHE_SUFFIX)) == NULL) return false;
+
+  file = fopen(name,"rb");
+  free(name);
+  if(file == NULL) return false;
+
+  fill_lod_header(&expected,&source,o,key);
+
+  if(fread(&h,sizeof(h),1,file) != 1 || h.n_lods <= 0) {
+    fclose(file);
+    return false;
+  }
+
+  /* everything but the number of levels has to match */
+  expected.n_lods = h.n_lods;
+  if(memcmp(&h,&expected,sizeof(h)) != 0 ||
+     (lods = (lod *) arena_alloc(o->mem,sizeof(lod) * h.n_lods)) == NULL) {
+    fclose(file);
+    return false;
+  }
+
+  for(i = 0; i < h.n_lods; i++){
+    if(fread(counts,sizeof(int),2,file) != 2 || counts[0] < 0 ||
+       counts[1] < 0) {
+      fclose(file);
+      return false;
+    }
+    lods[i].n_faces = counts[0];
+    lods[i].n_indices = counts[1];
+  }
+
+  for(i = 0; i < h.n_lods; i++){
+    lods[i].faces = alloc_face_array(o->mem,lods[i].n_faces);
+    lods[i].indices = (int *) arena_alloc(o->mem,sizeof(int) *
+                                                 (size_t) lods[i].n_indices);
+
+    if(lods[i].faces == NULL || lods[i].indices == NULL ||
+       fread(lods[i].faces,sizeof(face),lods[i].n_faces,file) !=
+         lods[i].n_faces ||
+       fread(lods[i].indices,sizeof(int),lods[i].n_indices,file) !=
+         lods[i].n_indices) {
+      fclose(file);
+      return false;
+    }
+
+    /* don't trust the file to point anywhere it shouldn't */
+    for(j = 0; j < lods[i].n_faces; j++)
+      if(lods[i].faces[j].first_index < 0 || lods[i].faces[j].n_vertices < 0 ||
+         lods[i].faces[j].first_index + lods[i].faces[j].n_vertices >
+           lods[i].n_indices) {
+        fclose(file);
+        return false;
+      }
+
+    for(j = 0; j < lods[i].n_indices; j++)
+      if(lods[i].indices[j] < 0 || lods[i].indices[j] >= o->n_vertices) {
+        fclose(file);
+        return false;
+      }
+  }
+
+  fclose(file);
+
+  o->lods = lods;
+  o->n_lods = h.n_lods;
+
+  return true;
+}
+
+
+/* save_lod_cache():
+   description: writes an object's levels of detail out to their cache,
+                under a temporary name first like save_cache()
+   inputs: the object, the .off filename, a key for the passes the object
+           went through after it was loaded
+   output: true if the cache was written
+ */
+bool save_lod_cache(object *o, const char *filename, unsigned int key){
+  lod_cache_header h;
+  struct stat source;
+  char *name, *temp;
+  FILE *file;
+  bool ok = true;
+  int i;
+
+  if(o == NULL || o->n_lods == 0 || stat(filename,&source) < 0) return false;
+  if((name = cache_name(filename,LOD_CACHE_SUFFIX)) == NULL) return false;
+
+  temp = (char *) malloc(strlen(name) + 32);
+  if(temp == NULL) {
+    free(name);
+    return false;
+  }
+  sprintf(temp,"%s.%ld",name,(long) getpid());
+
+  if((file = fopen(temp,"wb")) == NULL) {
+    free(temp);
+    free(name);
+    return false;
+  }
+
+  fill_lod_header(&h,&source,o,key);
+
+  if(fwrite(&h,sizeof(h),1,file) != 1)
+    ok = false;
+
+  for(i = 0; i < o->n_lods && ok; i++)
+    if(fwrite(&o->lods[i].n_faces,sizeof(int),1,file) != 1 ||
+       fwrite(&o->lods[i].n_indices,sizeof(int),1,file) != 1)
+      ok = false;
+
+  for(i = 0; i < o->n_lods && ok; i++)
+    if(fwrite(o->lods[i].faces,sizeof(face),o->lods[i].n_faces,file) !=
+         o->lods[i].n_faces ||
+       fwrite(o->lods[i].indices,sizeof(int),o->lods[i].n_indices,file) !=
+         o->lods[i].n_indices)
+      ok = false;
+
+  if(fclose(file) != 0)
+    ok = false;
+
+  if(ok == false || rename(temp,name) != 0) {
+    unlink(temp);
+    ok = false;
+  }
+
+  free(temp);
+  free(name);
+
+  return ok;
+}
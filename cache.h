@@ -0,0 +1,74 @@
+/********************
+ * FILE: cache.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for cache.c. Defines the layout of the binary geometry
+ *     cache and contains the prototypes for the interface functions
+ */
+
+#ifndef _CB_CACHE_H
+#define _CB_CACHE_H
+
+#include "common.h"
+
+/* the cache file sits next to the .off file with this on the end */
+#define CACHE_SUFFIX "c"
+
+/* bump this whenever the layout of the cache (or object) changes */
+#define CACHE_VERSION 3
+
+/* the start of every cache file. the source size and modification time
+   (to the nanosecond, where the file system keeps it) tell us if the .off
+   file has changed since the cache was written. after it come the vertex
+   array, the face array and the index buffer, exactly as they are in the
+   object */
+typedef struct {
+  char magic[4];
+  int version;
+  int byte_order;
+  int vertex_size;
+  int face_size;
+
+  long long source_size;
+  long long source_mtime;
+  long long source_mtime_nsec;
+
+  int n_vertices;
+  int n_faces;
+  int n_indices;
+} cache_header;
+
+/* the levels of detail are cached in their own file, as they're made after
+   the model has been through the passes, which can change every run */
+#define LOD_CACHE_SUFFIX "l"
+#define LOD_CACHE_VERSION 2
+
+/* the start of every level of detail cache file. the key says which passes
+   the model went through first, and the size of the object checks it came
+   out the same. then there's the number of faces and indices of each level,
+   followed by each level's faces and indices */
+typedef struct {
+  char magic[4];
+  int version;
+  int byte_order;
+  int face_size;
+
+  long long source_size;
+  long long source_mtime;
+  long long source_mtime_nsec;
+
+  unsigned int key;
+  int n_vertices;
+  int n_faces;
+  int n_indices;
+  int n_lods;
+} lod_cache_header;
+
+/* interface function prototypes */
+bool load_cache(object *,const char *);
+bool save_cache(object *,const char *);
+bool load_lod_cache(object *,const char *,unsigned int);
+bool save_lod_cache(object *,const char *,unsigned int);
+#endif /* !_CB_CACHE_H */
@@ -0,0 +1,316 @@
+/********************
+ * FILE: cluster.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Functions for splitting an object into clusters of triangles that can
+ *     be culled on their own. Each cluster knows a sphere around itself,
+ *     for throwing away clusters outside the view, and a cone around its
+ *     normals, for throwing away clusters that face completely away from
+ *     the eye. The bounds are worked out in parallel on the worker pool.
+ */
+
+#include <math.h> /*for sqrtf*/
+
+#include "common.h"
+#include "arena.h"
+#include "face.h"
+#include "vertex.h"
+#include "object.h"
+#include "pool.h"
+#include "cluster.h"
+
+/* the number of clusters each pool job works out the bounds for */
+#define CLUSTERS_PER_JOB 64
+
+/* what the bounds jobs share */
+typedef struct {
+  object *o;
+  cluster *clusters;
+  int n_clusters;
+} cluster_set;
+
+
+/* normalise():
+   description: makes a vector unit length, if it has any length at all
+   output: the length it was
+ */
+static float normalise(float *v){
+  float l = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+
+  if(l > 0) {
+    v[0] /= l;
+    v[1] /= l;
+    v[2] /= l;
+  }
+
+  return l;
+}
+
+
+/* triangle_normal():
+   description: the unit normal of a triangle, from the way it winds. zero
+                if the triangle has no area
+ */
+static void triangle_normal(object *o, int *tri, float *n){
+  vertex *a = o->vertices + tri[0];
+  vertex *b = o->vertices + tri[1];
+  vertex *c = o->vertices + tri[2];
+  float u[3], v[3];
+
+  u[0] = b->x - a->x; u[1] = b->y - a->y; u[2] = b->z - a->z;
+  v[0] = c->x - a->x; v[1] = c->y - a->y; v[2] = c->z - a->z;
+
+  n[0] = u[1] * v[2] - u[2] * v[1];
+  n[1] = u[2] * v[0] - u[0] * v[2];
+  n[2] = u[0] * v[1] - u[1] * v[0];
+
+  normalise(n);
+}
+
+
+/* cluster_bounds():
+   description: works out the sphere and normal cone of a cluster. the
+                sphere is centred on the middle of the cluster's box. the
+                cone's axis is the average normal, and its angle the
+                furthest any normal is from it
+ */
+static void cluster_bounds(object *o, cluster *c){
+  int *indices = o->indices + c->first_index;
+  float min[3], max[3], n[3], d[3], dist, mindot = 1;
+  int i, j;
+  vertex *v;
+
+  for(i = 0; i < 3; i++){
+    min[i] = max[i] = 0;
+    c->axis[i] = 0;
+  }
+
+  for(i = 0; i < c->n_indices; i++){
+    v = o->vertices + indices[i];
+    if(i == 0 || v->x < min[0]) min[0] = v->x;
+    if(i == 0 || v->y < min[1]) min[1] = v->y;
+    if(i == 0 || v->z < min[2]) min[2] = v->z;
+    if(i == 0 || v->x > max[0]) max[0] = v->x;
+    if(i == 0 || v->y > max[1]) max[1] = v->y;
+    if(i == 0 || v->z > max[2]) max[2] = v->z;
+  }
+
+  c->radius = 0;
+  for(i = 0; i < 3; i++)
+    c->centre[i] = (min[i] + max[i]) * 0.5f;
+
+  for(i = 0; i < c->n_indices; i++){
+    v = o->vertices + indices[i];
+    d[0] = v->x - c->centre[0];
+    d[1] = v->y - c->centre[1];
+    d[2] = v->z - c->centre[2];
+    dist = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    if(dist > c->radius)
+      c->radius = dist;
+  }
+
+  for(i = 0; i + 2 < c->n_indices; i += 3){
+    triangle_normal(o,indices + i,n);
+    for(j = 0; j < 3; j++)
+      c->axis[j] += n[j];
+  }
+
+  /* normals all over the place, so the cone is no use */
+  if(normalise(c->axis) == 0) {
+    c->cutoff = 2;
+    return;
+  }
+
+  for(i = 0; i + 2 < c->n_indices; i += 3){
+    triangle_normal(o,indices + i,n);
+    dist = n[0] * c->axis[0] + n[1] * c->axis[1] + n[2] * c->axis[2];
+    if(dist < mindot)
+      mindot = dist;
+  }
+
+  /* a cone 90 degrees or wider always has something facing the eye */
+  c->cutoff = mindot <= 0 ? 2 : sqrtf(1 - mindot * mindot);
+}
+
+
+/* bounds_job():
+   description: pool job working out the bounds of a block of clusters
+ */
+static void bounds_job(void *data, int job){
+  cluster_set *set = (cluster_set *) data;
+  int i, end = (job + 1) * CLUSTERS_PER_JOB;
+
+  if(end > set->n_clusters)
+    end = set->n_clusters;
+
+  for(i = job * CLUSTERS_PER_JOB; i < end; i++)
+    if(set->clusters[i].radius >= 0)
+      cluster_bounds(set->o,set->clusters + i);
+}
+
+
+/* build_clusters():
+   description: splits every GL_TRIANGLES face of the object into clusters
+     of at most CLUSTER_TRIANGLES triangles, as evenly as it can, and works
+     out their bounds. the triangles are taken in the order they're in, so
+     running the vertex cache pass first gives tighter clusters. other
+     faces get one cluster each that's never culled. the clusters come from
+     the object's arena
+   inputs: an alloced object that has been filled with all the data, the
+           worker pool (or NULL), where to put the number of clusters
+   output: the clusters, or NULL if there wasn't enough memory
+ */
+cluster *build_clusters(object *o, pool *workers, int *n_clusters){
+  cluster_set set;
+  cluster *c;
+  int i, j, n_tris, parts, first;
+  face *f;
+
+  *n_clusters = 0;
+  if(o == NULL) return NULL;
+
+  for(i = 0, set.n_clusters = 0; i < o->n_faces; i++){
+    f = o->faces + i;
+    if(f->draw_mode == GL_TRIANGLES)
+      set.n_clusters += (f->n_vertices / 3 + CLUSTER_TRIANGLES - 1) /
+                        CLUSTER_TRIANGLES;
+    else
+      set.n_clusters++;
+  }
+
+  set.o = o;
+  set.clusters = (cluster *) arena_alloc(o->mem,sizeof(cluster) *
+                                                (set.n_clusters + 1));
+  if(set.clusters == NULL) return NULL;
+
+  c = set.clusters;
+  for(i = 0; i < o->n_faces; i++){
+    f = o->faces + i;
+
+    if(f->draw_mode != GL_TRIANGLES) {
+      c->face = i;
+      c->first_index = f->first_index;
+      c->n_indices = f->n_vertices;
+      c->radius = -1;
+      c++;
+      continue;
+    }
+
+    /* split the triangles evenly between as few clusters as will do */
+    n_tris = f->n_vertices / 3;
+    parts = (n_tris + CLUSTER_TRIANGLES - 1) / CLUSTER_TRIANGLES;
+    first = f->first_index;
+    for(j = 0; j < parts; j++){
+      c->face = i;
+      c->first_index = first;
+      c->n_indices = 3 * ((n_tris * (j + 1)) / parts - (n_tris * j) / parts);
+      c->radius = 0;
+      first += c->n_indices;
+      c++;
+    }
+  }
+
+  run_pool(workers,(set.n_clusters + CLUSTERS_PER_JOB - 1) / CLUSTERS_PER_JOB,
+           bounds_job,&set);
+
+  *n_clusters = set.n_clusters;
+  return set.clusters;
+}
+
+
+/* setup_cluster_view():
+   description: works out the planes around the view and the position of
+                the eye in object space, from the GL matrices. the planes
+                come straight out of projection * modelview, and the eye
+                from undoing the modelview
+   inputs: the view to fill, the modelview and projection matrices (column
+           major, as GL gives them)
+ */
+void setup_cluster_view(cluster_view *view, float *mv, float *proj){
+  float m[16], a[3][3], inv[3][3], det;
+  int i, j, k;
+
+  /* m = proj * mv */
+  for(i = 0; i < 4; i++)
+    for(j = 0; j < 4; j++){
+      m[j * 4 + i] = 0;
+      for(k = 0; k < 4; k++)
+        m[j * 4 + i] += proj[k * 4 + i] * mv[j * 4 + k];
+    }
+
+  /* row 3 plus and minus rows 0, 1 and 2 */
+  for(i = 0; i < 3; i++)
+    for(j = 0; j < 4; j++){
+      view->planes[2 * i][j] = m[j * 4 + 3] + m[j * 4 + i];
+      view->planes[2 * i + 1][j] = m[j * 4 + 3] - m[j * 4 + i];
+    }
+
+  for(i = 0; i < 6; i++){
+    det = sqrtf(view->planes[i][0] * view->planes[i][0] +
+                view->planes[i][1] * view->planes[i][1] +
+                view->planes[i][2] * view->planes[i][2]);
+    if(det > 0)
+      for(j = 0; j < 4; j++)
+        view->planes[i][j] /= det;
+  }
+
+  /* the eye is at -inverse(R) * t, where R is the top left 3x3 of the
+     modelview and t its translation */
+  for(i = 0; i < 3; i++)
+    for(j = 0; j < 3; j++)
+      a[i][j] = mv[j * 4 + i];
+
+  inv[0][0] = a[1][1] * a[2][2] - a[1][2] * a[2][1];
+  inv[0][1] = a[0][2] * a[2][1] - a[0][1] * a[2][2];
+  inv[0][2] = a[0][1] * a[1][2] - a[0][2] * a[1][1];
+  inv[1][0] = a[1][2] * a[2][0] - a[1][0] * a[2][2];
+  inv[1][1] = a[0][0] * a[2][2] - a[0][2] * a[2][0];
+  inv[1][2] = a[0][2] * a[1][0] - a[0][0] * a[1][2];
+  inv[2][0] = a[1][0] * a[2][1] - a[1][1] * a[2][0];
+  inv[2][1] = a[0][1] * a[2][0] - a[0][0] * a[2][1];
+  inv[2][2] = a[0][0] * a[1][1] - a[0][1] * a[1][0];
+
+  det = a[0][0] * inv[0][0] + a[0][1] * inv[1][0] + a[0][2] * inv[2][0];
+  if(det == 0) det = 1;
+
+  for(i = 0; i < 3; i++)
+    view->eye[i] = -(inv[i][0] * mv[12] + inv[i][1] * mv[13] +
+                     inv[i][2] * mv[14]) / det;
+}
+
+
+/* cull_cluster():
+   description: checks if a cluster can be seen. it can't if its sphere is
+                completely outside one of the planes of the view, or (if
+                back faces are being culled) the eye is behind every
+                triangle that could be in its normal cone, wherever in the
+                sphere the triangle is
+   inputs: the cluster, the view, whether back faces are culled
+   output: cluster_visible, cluster_outside or cluster_back
+ */
+cluster_cull cull_cluster(cluster *c, cluster_view *view, bool back_cull){
+  float d[3], dist, along;
+  int i;
+
+  if(c->radius < 0) return cluster_visible;
+
+  for(i = 0; i < 6; i++)
+    if(view->planes[i][0] * c->centre[0] + view->planes[i][1] * c->centre[1] +
+       view->planes[i][2] * c->centre[2] + view->planes[i][3] < -c->radius)
+      return cluster_outside;
+
+  if(back_cull == false || c->cutoff > 1) return cluster_visible;
+
+  d[0] = c->centre[0] - view->eye[0];
+  d[1] = c->centre[1] - view->eye[1];
+  d[2] = c->centre[2] - view->eye[2];
+  dist = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+  along = d[0] * c->axis[0] + d[1] * c->axis[1] + d[2] * c->axis[2];
+
+  if(along >= c->cutoff * dist + c->radius * (1 + c->cutoff))
+    return cluster_back;
+
+  return cluster_visible;
+}
@@ -0,0 +1,54 @@
+/********************
+ * FILE: cluster.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for cluster.c. Defines the cluster and view structures and
+ *     contains the prototypes for the interface functions
+ */
+
+#ifndef _CB_CLUSTER_H
+#define _CB_CLUSTER_H
+
+#include "common.h"
+#include "object.h"
+#include "pool.h"
+
+/* the most triangles in a cluster. faces are split into clusters of
+   between half this and this many */
+#define CLUSTER_TRIANGLES 128
+
+/* what cull_cluster() decided */
+typedef enum { cluster_visible, cluster_outside, cluster_back } cluster_cull;
+
+/* cluster struct. a run of triangles from one face, with what we need to
+   know to skip drawing them */
+typedef struct cluster_t {
+  /* the face it comes from, and its part of the index buffer */
+  int face;
+  int first_index;
+  int n_indices;
+
+  /* a sphere around all its vertices. a negative radius means it's never
+     culled (it isn't GL_TRIANGLES) */
+  float centre[3];
+  float radius;
+
+  /* a cone around all its triangles' normals. the cutoff is the sine of
+     the cone's angle, or more than 1 if the cone is too wide to use */
+  float axis[3];
+  float cutoff;
+} cluster;
+
+/* where the eye and the sides of the view are, in object space */
+typedef struct {
+  float planes[6][4];
+  float eye[3];
+} cluster_view;
+
+/* interface function prototypes */
+cluster *build_clusters(object *,pool *,int *);
+void setup_cluster_view(cluster_view *,float *,float *);
+cluster_cull cull_cluster(cluster *,cluster_view *,bool);
+#endif /* !_CB_CLUSTER_H */
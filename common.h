@@ -19,6 +19,8 @@ typedef enum {false, true} bool;
 typedef enum { x, y, z} axis;
 
 /* different rendering types */
-typedef enum { normal, display_list, vertex_array} render_type;
+typedef enum { normal, display_list, vertex_array, strip, clustered,
+               hierarchy, buffer_object, multi_draw,
+               shader_program, software} render_type;
 
 #endif /*! _CB_COMMON_H */
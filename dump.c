@@ -0,0 +1,262 @@
+/********************
+ * FILE: dump.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Functions for saving every nth frame drawn as a .ppm file, without
+ *     slowing down the drawing much. Each frame is read back into one of a
+ *     ring of pixel buffer objects, which GL fills in its own time. The
+ *     frame is only copied out when its buffer comes round again, by which
+ *     time it's long done, and then handed to a couple of writer threads
+ *     that turn it the right way up and write it out.
+ */
+
+#include <stdio.h>
+#include <stdlib.h> /*for malloc*/
+#include <string.h> /*for memcpy*/
+#include <errno.h>
+#include <sys/stat.h> /*for mkdir*/
+
+#include "common.h"
+#include "platform.h"
+#include "dump.h"
+
+
+/* write_frame():
+   description: writes a frame out as a binary .ppm. GL gives the bottom
+                row first, and a .ppm wants the top row first
+   inputs: the dumper, the frame
+   output: false if the file couldn't be written
+ */
+static bool write_frame(dumper *d, dump_frame *f){
+  char name[FILENAME_MAX];
+  unsigned char *row, *in;
+  FILE *file;
+  int x, y;
+  bool ok;
+
+  snprintf(name,sizeof(name),"%s/frame%06ld.ppm",d->dir,f->number);
+
+  row = (unsigned char *) malloc(3 * (size_t) f->width + 1);
+  if(row == NULL || (file = fopen(name,"wb")) == NULL) {
+    free(row);
+    return false;
+  }
+
+  fprintf(file,"P6\n%d %d\n255\n",f->width,f->height);
+
+  for(y = f->height - 1; y >= 0; y--){
+    in = f->pixels + 4 * (size_t) f->width * y;
+    for(x = 0; x < f->width; x++)
+      memcpy(row + 3 * x,in + 4 * x,3);
+    fwrite(row,3,f->width,file);
+  }
+
+  ok = ferror(file) ? false : true;
+  if(fclose(file) != 0)
+    ok = false;
+  free(row);
+
+  return ok;
+}
+
+
+/* writer():
+   description: the main loop of each writer thread. takes frames off the
+                queue and writes them, until it's told to quit and the
+                queue is empty
+ */
+static void *writer(void *arg){
+  dumper *d = (dumper *) arg;
+  dump_frame f;
+  bool ok;
+
+  pthread_mutex_lock(&d->lock);
+  while(true){
+    while(d->count == 0 && d->quit == false)
+      pthread_cond_wait(&d->more,&d->lock);
+
+    if(d->count == 0) break;
+
+    f = d->queue[d->first];
+    d->first = (d->first + 1) % DUMP_QUEUE;
+    d->count--;
+    pthread_cond_signal(&d->space);
+
+    pthread_mutex_unlock(&d->lock);
+    ok = write_frame(d,&f);
+    free(f.pixels);
+    pthread_mutex_lock(&d->lock);
+
+    if(ok == true)
+      d->written++;
+    else if(d->failed == false) {
+      fprintf(stderr,"Error: unable to write frame %ld to %s\n",f.number,
+              d->dir);
+      d->failed = true;
+    }
+  }
+  pthread_mutex_unlock(&d->lock);
+
+  return NULL;
+}
+
+
+/* create_dumper():
+   description: makes the directory the frames go in (if it isn't there),
+                the pixel buffer objects and the writer threads. needs a
+                current GL context
+   inputs: the directory, save every this many frames
+   output: the dumper, or NULL if the directory or threads can't be made
+ */
+dumper *create_dumper(const char *dir, int every){
+  dumper *d;
+  int i;
+
+  if(dir == NULL || (mkdir(dir,0755) != 0 && errno != EEXIST))
+    return NULL;
+
+  if((d = (dumper *) malloc(sizeof(dumper))) == NULL) return NULL;
+  memset(d,0,sizeof(dumper));
+
+  if((d->dir = (char *) malloc(strlen(dir) + 1)) == NULL) {
+    free(d);
+    return NULL;
+  }
+  strcpy(d->dir,dir);
+  d->every = every < 1 ? 1 : every;
+
+  for(i = 0; i < DUMP_BUFFERS; i++)
+    glGenBuffers(1,&d->slots[i].buffer);
+
+  pthread_mutex_init(&d->lock,NULL);
+  pthread_cond_init(&d->more,NULL);
+  pthread_cond_init(&d->space,NULL);
+
+  for(i = 0; i < DUMP_THREADS; i++)
+    if(pthread_create(&d->threads[i],NULL,writer,d) != 0)
+      break;
+
+  d->n_threads = i;
+  if(d->n_threads == 0) {
+    free(d->dir);
+    free(d);
+    return NULL;
+  }
+
+  return d;
+}
+
+
+/* collect():
+   description: copies a frame out of its pixel buffer object and queues it
+                for the writers, waiting if the queue is full
+   inputs: the dumper, the slot the frame is in
+ */
+static void collect(dumper *d, dump_slot *s){
+  dump_frame f;
+  void *pixels;
+
+  s->pending = false;
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER,s->buffer);
+  pixels = glMapBuffer(GL_PIXEL_PACK_BUFFER,GL_READ_ONLY);
+  f.pixels = (unsigned char *) malloc(s->size + 1);
+
+  if(pixels != NULL && f.pixels != NULL)
+    memcpy(f.pixels,pixels,s->size);
+
+  if(pixels != NULL)
+    glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+
+  if(pixels == NULL || f.pixels == NULL) {
+    free(f.pixels);
+    return;
+  }
+
+  f.width = s->width;
+  f.height = s->height;
+  f.number = s->number;
+
+  pthread_mutex_lock(&d->lock);
+  while(d->count == DUMP_QUEUE)
+    pthread_cond_wait(&d->space,&d->lock);
+
+  d->queue[(d->first + d->count) % DUMP_QUEUE] = f;
+  d->count++;
+  pthread_cond_signal(&d->more);
+  pthread_mutex_unlock(&d->lock);
+}
+
+
+/* capture_frame():
+   description: called after each frame is drawn. every nth one is read
+                back into the next pixel buffer object in the ring, without
+                waiting for it. the frame that was in there before is
+                queued for writing first
+   inputs: the dumper, the size of the frame
+ */
+void capture_frame(dumper *d, int w, int h){
+  dump_slot *s;
+  long size = 4L * w * h;
+
+  if(d == NULL || d->frames++ % d->every != 0) return;
+
+  s = d->slots + d->next_slot;
+  d->next_slot = (d->next_slot + 1) % DUMP_BUFFERS;
+
+  if(s->pending == true)
+    collect(d,s);
+
+  glBindBuffer(GL_PIXEL_PACK_BUFFER,s->buffer);
+  if(s->size != size) {
+    glBufferData(GL_PIXEL_PACK_BUFFER,size,NULL,GL_STREAM_READ);
+    s->size = size;
+  }
+
+  glReadPixels(0,0,w,h,GL_RGBA,GL_UNSIGNED_BYTE,NULL);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER,0);
+
+  s->width = w;
+  s->height = h;
+  s->number = d->frames - 1;
+  s->pending = true;
+}
+
+
+/* finish_dumper():
+   description: queues the frames still being read back, oldest first,
+                then waits for the writers to finish and frees the dumper.
+                prints how many frames were written to stderr
+   inputs: the dumper
+ */
+void finish_dumper(dumper *d){
+  int i;
+
+  if(d == NULL) return;
+
+  for(i = 0; i < DUMP_BUFFERS; i++)
+    if(d->slots[(d->next_slot + i) % DUMP_BUFFERS].pending == true)
+      collect(d,d->slots + (d->next_slot + i) % DUMP_BUFFERS);
+
+  pthread_mutex_lock(&d->lock);
+  d->quit = true;
+  pthread_cond_broadcast(&d->more);
+  pthread_mutex_unlock(&d->lock);
+
+  for(i = 0; i < d->n_threads; i++)
+    pthread_join(d->threads[i],NULL);
+
+  for(i = 0; i < DUMP_BUFFERS; i++)
+    glDeleteBuffers(1,&d->slots[i].buffer);
+
+  fprintf(stderr,"dump: %ld frames written to %s\n",d->written,d->dir);
+
+  pthread_mutex_destroy(&d->lock);
+  pthread_cond_destroy(&d->more);
+  pthread_cond_destroy(&d->space);
+  free(d->dir);
+  free(d);
+}
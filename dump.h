@@ -0,0 +1,73 @@
+/********************
+ * FILE: dump.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for dump.c. Defines the frame dumper structure and
+ *     contains the prototypes for the interface functions
+ */
+
+#ifndef _CB_DUMP_H
+#define _CB_DUMP_H
+
+#include <pthread.h>
+
+#include "common.h"
+#include "platform.h"
+
+/* how many frames can be read back at once, waiting in pixel buffer
+   objects, and how many can wait to be written once they're back */
+#define DUMP_BUFFERS 3
+#define DUMP_QUEUE 32
+
+/* the threads writing the files */
+#define DUMP_THREADS 2
+
+/* a frame read back from GL, waiting to be written */
+typedef struct {
+  unsigned char *pixels;
+  int width;
+  int height;
+  long number;
+} dump_frame;
+
+/* a pixel buffer object a frame is being read back into */
+typedef struct {
+  GLuint buffer;
+  long size;
+  bool pending;
+  int width;
+  int height;
+  long number;
+} dump_slot;
+
+/* dumper struct. the ring of pixel buffer objects, and the queue of frames
+   the writer threads take from */
+typedef struct dumper_t {
+  char *dir;
+  int every;
+  long frames;
+  long written;
+
+  dump_slot slots[DUMP_BUFFERS];
+  int next_slot;
+
+  pthread_t threads[DUMP_THREADS];
+  int n_threads;
+  pthread_mutex_t lock;
+  pthread_cond_t more;
+  pthread_cond_t space;
+
+  dump_frame queue[DUMP_QUEUE];
+  int first;
+  int count;
+  bool quit;
+  bool failed;
+} dumper;
+
+/* interface function prototypes */
+dumper *create_dumper(const char *,int);
+void capture_frame(dumper *,int,int);
+void finish_dumper(dumper *);
+#endif /* !_CB_DUMP_H */
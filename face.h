@@ -12,17 +12,17 @@
 #define _CB_FACE_H
 #include "platform.h"
 #include "common.h"
+#include "arena.h"
 
+/* face struct. a view into the object's index buffer, the face's
+   indices are the n_vertices starting at first_index */
 typedef struct face_t {
-  /* array of indices into a vertex array */
-  int *vertex_indices;
+  /* where this face's vertex indices start in the object's index buffer */
+  int first_index;
 
   /* the number of vertices for this face */
   int n_vertices;
 
-  /* the number of vertices we've added */
-  int filled_vertices;
-
   /* the GL mode for drawing this face */
   GLenum draw_mode;
 
@@ -32,11 +32,7 @@ typedef struct face_t {
 } face;
 
 /* interface function prototypes */
-face *alloc_face_array(int );
+face *alloc_face_array(arena *,int );
 bool init_face(face *,int);
-void free_face(face *);
-void add_index(face *,int);
 void print_face(face);
-face *add_face_to_array(face *,face, int *);
-bool join_faces(face *,face);
 #endif /* !_CB_FACE_H */
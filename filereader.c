@@ -6,118 +6,685 @@
  * DESCRIPTION:
  *     Functions for reading a NOFF file. N4OFF files or any other OFF format
  *     are unsupported at the moment.
+ *     The file is memory mapped and tokenized in place, numbers are converted
+ *     by hand rather than going through stdio. The results are identical to
+ *     what fscanf() would give us.
  */
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h> /*for open*/
+#include <unistd.h> /*for close*/
+#include <sys/mman.h> /*for mmap*/
+#include <sys/stat.h> /*for fstat*/
 
 #include "common.h"
+#include "arena.h"
 #include "object.h"
 #include "face.h"
 #include "vertex.h"
+#include "pool.h"
+#include "scan.h"
+#include "cache.h"
 #include "filereader.h"
 
-/* readFile():
-   description: does all the work. see file description
+/* the longest number we'll hand off to strtof() */
+#define MAX_TOKEN 64
+
+/* the longest run of digits we convert in one go */
+#define MAX_DIGITS 8
+
+/* the largest mantissa, and power of ten, a float can hold exactly */
+#define EXACT_MANTISSA (1 << 24)
+#define EXACT_POW10 10
+
+/* the maximum number of colour values on the end of a face line */
+#define MAX_COLOURS 4
+
+/* files smaller than this aren't worth splitting up between threads */
+#define PARALLEL_SIZE (64 * 1024)
+
+/* pieces per thread, so a slow piece doesn't hold everyone up */
+#define CHUNKS_PER_THREAD 4
+
+/* powers of ten that are exactly representable as a float */
+static const float pow10_table[EXACT_POW10 + 1] = {
+  1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+};
+
+/* for shifting the integer part along to make room for the fraction */
+static const unsigned int pow10_int[MAX_DIGITS + 1] = {
+  1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000
+};
+
+/* a cursor into the memory mapped file. limit is the end of the whole
+   mapping, which may be past the end of what we are reading */
+typedef struct {
+  const char *pos;
+  const char *end;
+  const char *limit;
+} cursor;
+
+
+/* is_space():
+   description: true if the character is whitespace (or any other control
+                character, which is near enough for OFF files)
  */
-void readfile(object *o, const char *filename){
-  int i,j,in;
-  int n_vertices,n_faces,n_indices,index;
-  vertex v;
-  face f;
-  FILE *file;
-  char str[1024];
+static bool is_space(char c){
+  return ((unsigned char) c) <= ' ' ? true : false;
+}
 
-  /* Attempt to open the file */
-  if((file = fopen(filename,"r"))==NULL){
-    fprintf(stderr,"Error: failed to open file %s\n",filename);
-    exit(1);
+
+/* skip_space():
+   description: moves the cursor to the start of the next token
+ */
+static void skip_space(cursor *c){
+  c->pos = scan_space(c->pos,c->end);
+}
+
+
+/* is_digit():
+   description: true if the character is 0-9
+ */
+static bool is_digit(char c){
+  return (c >= '0' && c <= '9') ? true : false;
+}
+
+
+/* read_digits():
+   description: converts a run of digits, 8 at a time if there's room to
+                read that far
+   inputs: the cursor, the start of the run, the number of digits (up to 8)
+   output: the value of the digits
+ */
+static unsigned int read_digits(cursor *c, const char *p, int n){
+  unsigned int value = 0;
+
+  if(n <= 0) return 0;
+
+  if(p + 8 <= c->limit)
+    return parse_digits(p,n);
+
+  while(n-- > 0)
+    value = value * 10 + (*p++ - '0');
+
+  return value;
+}
+
+
+/* slow_float():
+   description: converts a number the hard way, for anything the fast path
+                can't handle exactly (long mantissas, big exponents, nan...)
+   inputs: the start and end of the token, pointer to store the result
+   output: true if a number was read
+ */
+static bool slow_float(const char *start, const char *end, float *f){
+  char token[MAX_TOKEN];
+  char *stop;
+  int length = end - start;
+
+  if(length <= 0 || length >= MAX_TOKEN) return false;
+
+  /* the mapped file isn't null terminated, so take a copy */
+  memcpy(token,start,length);
+  token[length] = '\0';
+
+  *f = strtof(token,&stop);
+
+  return stop != token ? true : false;
+}
+
+
+/* next_float():
+   description: reads the next float from the cursor. Short decimal numbers
+                are converted with a single exact multiply or divide, which
+                rounds the same way strtof() does.
+   inputs: the cursor, pointer to store the result
+   output: true if a number was read
+ */
+static bool next_float(cursor *c, float *f){
+  const char *p, *start, *stop, *digits;
+  unsigned long long mantissa;
+  int n_int, n_frac = 0, exponent = 0, exp_value = 0;
+  bool negative = false, exp_negative = false;
+  float value;
+
+  skip_space(c);
+  start = p = c->pos;
+  stop = scan_token(p,c->end);
+
+  if(p < stop && (*p == '-' || *p == '+')) {
+    negative = (*p == '-') ? true : false;
+    p++;
   }
 
-  /* Check this is a NOFF file */
-  fscanf(file,"%s",str);
-  if(strcmp(str,"NOFF")!=0){
-    fprintf(stderr,"Error: file %s is not of NOFF format\n",filename);
-    exit(1);
+  /* the integer part */
+  for(digits = p; p < stop && is_digit(*p); p++);
+  n_int = p - digits;
+  if(n_int > MAX_DIGITS) goto slow;
+  mantissa = read_digits(c,digits,n_int);
+
+  /* the fractional part */
+  if(p < stop && *p == '.') {
+    for(digits = ++p; p < stop && is_digit(*p); p++);
+    n_frac = p - digits;
+    if(n_frac > MAX_DIGITS) goto slow;
+    mantissa = mantissa * pow10_int[n_frac] + read_digits(c,digits,n_frac);
+    exponent = -n_frac;
   }
 
-  /* read in the number of vertices, faces and edges */
-  fscanf(file,"%d %d %*d",&n_vertices,&n_faces);
+  /* no digits at all, maybe it's something like nan or inf */
+  if(n_int + n_frac == 0)
+    goto slow;
 
-  /* init the object model */
-  if(init_object(o,n_vertices,n_faces)==false){
-    fprintf(stderr,"Error: unsuccessful call to init_object\n");
+  /* the exponent */
+  if(p < stop && (*p == 'e' || *p == 'E')) {
+    p++;
+    if(p < stop && (*p == '-' || *p == '+')) {
+      exp_negative = (*p == '-') ? true : false;
+      p++;
+    }
+    if(p == stop || !is_digit(*p))
+      goto slow;
+    for(; p < stop && is_digit(*p); p++)
+      if(exp_value < 10000)
+        exp_value = exp_value * 10 + (*p - '0');
+    exponent += exp_negative ? -exp_value : exp_value;
+  }
+
+  /* the number must end with whitespace */
+  if(p != stop)
+    goto slow;
+
+  /* too big to be sure of the rounding */
+  if(mantissa >= EXACT_MANTISSA)
+    goto slow;
+
+  value = (float) mantissa;
+  if(mantissa == 0 || exponent == 0)
+    ;
+  else if(exponent < 0 && exponent >= -EXACT_POW10)
+    value /= pow10_table[-exponent];
+  else if(exponent > 0 && exponent <= EXACT_POW10)
+    value *= pow10_table[exponent];
+  else
+    goto slow;
+
+  *f = negative ? -value : value;
+  c->pos = stop;
+  return true;
+
+slow:
+  /* let libc sort it out */
+  if(slow_float(start,stop,f) == false)
+    return false;
+
+  c->pos = stop;
+  return true;
+}
+
+
+/* next_int():
+   description: reads the next integer from the cursor
+   inputs: the cursor, pointer to store the result
+   output: true if a number was read
+ */
+static bool next_int(cursor *c, int *i){
+  const char *p, *digits;
+  bool negative = false;
+  int value = 0;
+
+  skip_space(c);
+  p = c->pos;
+
+  if(p < c->end && (*p == '-' || *p == '+')) {
+    negative = (*p == '-') ? true : false;
+    p++;
+  }
+
+  for(digits = p; p < c->end && is_digit(*p); p++);
+
+  if(p == digits)
+    return false;
+
+  if(p - digits <= MAX_DIGITS)
+    value = read_digits(c,digits,p - digits);
+  else
+    for(; digits < p; digits++)
+      value = value * 10 + (*digits - '0');
+
+  *i = negative ? -value : value;
+  c->pos = p;
+  return true;
+}
+
+
+/* next_line():
+   description: moves the cursor past the end of the current line
+   inputs: the cursor
+   output: the end of the line that was skipped
+ */
+static const char *next_line(cursor *c){
+  const char *eol;
+
+  eol = memchr(c->pos,'\n',c->end - c->pos);
+
+  if(eol == NULL) {
+    c->pos = c->end;
+    return c->end;
+  }
+
+  c->pos = eol + 1;
+  return eol;
+}
+
+
+/* read_colour():
+   description: reads the optional colour values on the end of a face line
+   inputs: the cursor, the face to fill in
+ */
+static void read_colour(cursor *c, face *f){
+  cursor line;
+  int in = 0;
+
+  /* only look at what's left on this line */
+  line.pos = c->pos;
+  line.limit = c->limit;
+  line.end = next_line(c);
+
+  /* zero the alpha value*/
+  f->colour[3]=0;
+
+  /* try and load the colours */
+  while(in < MAX_COLOURS && next_float(&line,&(f->colour[in])))
+    in++;
+
+  /* if we didn't load any colours set the red value to the default */
+  if(in <= 0) {
+    f->colour[0] = DEFAULT_COLOUR;
+    in=1;
+  }
+
+  /* set all the others to the first if only 1 value */
+  if(in < 3)
+    for(;in<3;in++)
+      f->colour[in] = f->colour[0];
+}
+
+
+/* read_vertex():
+   description: reads the position and normal of a vertex
+   inputs: the cursor, the vertex to fill in
+   output: true if all six numbers were read
+ */
+static bool read_vertex(cursor *c, vertex *v){
+  bool ok;
+
+  ok = next_float(c,&(v->x)) &&
+       next_float(c,&(v->y)) &&
+       next_float(c,&(v->z)) &&
+       next_float(c,&(v->normX)) &&
+       next_float(c,&(v->normY)) &&
+       next_float(c,&(v->normZ));
+
+#ifdef DEBUG
+  print_vertex(*v);
+#endif
+
+  return ok;
+}
+
+
+/* read_face():
+   description: reads the vertex indices and colour of a face. the indices
+                go on the end of the index buffer of the given object
+   inputs: the cursor, the object to put the indices in, the face to fill in
+   output: true if the number of indices and all the indices were read
+ */
+static bool read_face(cursor *c, object *o, face *f){
+  int j,n_indices,*indices;
+  bool ok = true;
+
+  /* read in the number of indices */
+  if(next_int(c,&n_indices) == false)
+    return false;
+
+  /* init the face and make room for its indices */
+  if(init_face(f,n_indices)==false || (indices = add_indices(o,f))==NULL){
+    fprintf(stderr,"Error: unsuccessful call to init_face\n");
     exit(1);
   }
 
-  /* load all the vertices */
-  for(i = 0; i < o->n_vertices; i++) {
-    /* read in a line of vertices*/
-    fscanf(file,"%f %f %f %f %f %f",
-                &(v.x),&(v.y),&(v.z),&(v.normX),&(v.normY),&(v.normZ));
+  /* load all the indices*/
+  for(j=0; j < n_indices ; j++){
+    if(next_int(c,indices + j) == false) {
+      indices[j] = 0;
+      ok = false;
+    }
 
 #ifdef DEBUG
-    print_vertex(v);
+    printf("[%d] = %d ",j,indices[j]);
 #endif
+  }
+#ifdef DEBUG
+  printf("\n");
+#endif
+
+  /* the rest of the line holds the colour */
+  read_colour(c,f);
+
+#ifdef DEBUG
+  print_face(*f);
+#endif
+
+  return ok;
+}
+
 
-    /* store it */
+/* read_body():
+   description: reads all the vertices and faces one after the other
+   inputs: the cursor (just past the header), the initialised object
+ */
+static void read_body(cursor *c, object *o){
+  int i;
+  vertex v;
+  face f;
+
+  /* load all the vertices */
+  for(i = 0; i < o->n_vertices; i++) {
+    read_vertex(c,&v);
     add_vertex(o,v);
   }
 
   /* load all the faces */
   for(i = 0; i < o->n_faces; i++) {
-    /* read in the number of indices */
-    fscanf(file,"%d",&n_indices);
+    read_face(c,o,&f);
+    add_face(o,f);
+  }
+}
 
-    /* init the face */
-    if(init_face(&f,n_indices)==false){
-      fprintf(stderr,"Error: unsuccessful call to init_face\n");
-      exit(1);
-    }
 
-    /* load all the indices*/
-    for(j=0; j < n_indices ; j++){
-      fscanf(file,"%d",&index);
+/* a piece of the file for one of the worker threads to read */
+typedef struct {
+  const char *start;
+  const char *end;
 
-#ifdef DEBUG
-      printf("[%d] = %d ",j,index);
-#endif
+  /* the number of the first non blank line in this chunk, and how many */
+  int first_record;
+  int n_records;
 
-      add_index(&f,index);
-    }
-#ifdef DEBUG
-    printf("\n");
-#endif
+  /* only the index buffer of this is used. the indices of the faces in
+     this chunk go here until we know where they go in the real object */
+  object part;
+  int first_index;
+
+  /* false if a line didn't look the way we expected */
+  bool ok;
+} chunk;
 
-    /* grab the rest of the line*/
-    fgets(str,1024,file);
+/* everything the worker threads need to get at */
+typedef struct {
+  object *o;
+  chunk *chunks;
+  const char *limit;
+} chunk_set;
+
+
+/* next_record():
+   description: finds the next non blank line in a chunk
+   inputs: the cursor for the chunk, the cursor to set to the line
+   output: false if there are no more lines
+ */
+static bool next_record(cursor *c, cursor *line){
+  /* blank lines just get skipped over along with the whitespace */
+  skip_space(c);
+  if(c->pos == c->end) return false;
 
-    /* zero the alpha value*/
-    f.colour[3]=0;
+  line->pos = c->pos;
+  line->limit = c->limit;
+  line->end = next_line(c);
+
+  return true;
+}
+
+
+/* count_chunk():
+   description: worker job. counts the non blank lines in a chunk
+ */
+static void count_chunk(void *data, int job){
+  chunk *ch = ((chunk_set *) data)->chunks + job;
+  cursor c, line;
+
+  c.pos = ch->start;
+  c.end = ch->end;
+  c.limit = ((chunk_set *) data)->limit;
+
+  ch->n_records = 0;
+  while(next_record(&c,&line))
+    ch->n_records++;
+}
+
+
+/* parse_chunk():
+   description: worker job. reads all the lines in a chunk straight into
+                the object. each line must hold exactly one vertex or face
+ */
+static void parse_chunk(void *data, int job){
+  chunk_set *set = (chunk_set *) data;
+  chunk *ch = set->chunks + job;
+  object *o = set->o;
+  cursor c, line;
+  int record;
+
+  c.pos = ch->start;
+  c.end = ch->end;
+  c.limit = set->limit;
+
+  for(record = ch->first_record; next_record(&c,&line); record++){
+    if(record < o->n_vertices) {
+      /* a vertex line has six numbers and nothing else */
+      if(read_vertex(&line,o->vertices + record) == false) ch->ok = false;
+      skip_space(&line);
+      if(line.pos != line.end) ch->ok = false;
+
+    } else if(record < o->n_vertices + o->n_faces) {
+      if(read_face(&line,&ch->part,o->faces + record - o->n_vertices)==false)
+        ch->ok = false;
+
+    } else break;
+  }
+}
+
+
+/* join_chunk():
+   description: worker job. copies a chunk's indices into the object and
+                moves its faces along to match
+ */
+static void join_chunk(void *data, int job){
+  chunk_set *set = (chunk_set *) data;
+  chunk *ch = set->chunks + job;
+  object *o = set->o;
+  int first,last;
+
+  memcpy(o->indices + ch->first_index,ch->part.indices,
+         sizeof(int) * ch->part.n_indices);
+
+  /* the faces in this chunk, if there are any */
+  first = ch->first_record - o->n_vertices;
+  last = first + ch->n_records;
+  if(first < 0) first = 0;
+  if(last > o->n_faces) last = o->n_faces;
+
+  for(; first < last; first++)
+    o->faces[first].first_index += ch->first_index;
+}
+
+
+/* read_body_parallel():
+   description: reads the vertices and faces by splitting the file at line
+                boundaries and giving each piece to a worker thread
+   inputs: the cursor (just past the header), the initialised object, the
+           worker pool
+   output: false if the file isn't laid out one vertex/face per line, in
+           which case the object is left empty
+ */
+static bool read_body_parallel(cursor *c, object *o, pool *workers){
+  chunk_set set;
+  chunk *ch;
+  const char *split;
+  int i,n_chunks,total;
+  bool ok = true;
 
-    /* try and load the coloura */
-    in = sscanf(str,"%f %f %f %f",
-               &f.colour[0],&f.colour[1],&f.colour[2],&f.colour[3]);
+  n_chunks = workers->n_threads * CHUNKS_PER_THREAD;
 
-    /* if we didn't load any colours set the red value to the default */
-    if(in <= 0) {
-      f.colour[0] = DEFAULT_COLOUR;
-      in=1;
+  set.o = o;
+  set.limit = c->limit;
+  set.chunks = (chunk *) malloc(sizeof(chunk) * n_chunks);
+  if(set.chunks == NULL) return false;
+
+  /* split the file into roughly even pieces, moving each split point
+     along to the start of the next line */
+  split = c->pos;
+  for(i = 0; i < n_chunks; i++){
+    ch = set.chunks + i;
+    ch->start = split;
+    ch->ok = true;
+    ch->part.indices = NULL;
+    ch->part.n_indices = ch->part.index_capacity = 0;
+    ch->part.mem = NULL;
+
+    if(i == n_chunks - 1)
+      split = c->end;
+    else {
+      split = c->pos + (c->end - c->pos) / n_chunks * (i + 1);
+      if(split < ch->start) split = ch->start;
+      split = memchr(split,'\n',c->end - split);
+      split = split == NULL ? c->end : split + 1;
     }
+    ch->end = split;
+  }
 
-    /* set all the others to the first if only 1 value */
-    if(in < 3)
-      for(;in<3;in++)
-        f.colour[in] = f.colour[0];
+  /* count the lines in each piece so we know where each one starts */
+  run_pool(workers,n_chunks,count_chunk,&set);
 
-#ifdef DEBUG
-    print_face(f);
-#endif
+  for(total = 0, i = 0; i < n_chunks; i++){
+    set.chunks[i].first_record = total;
+    total += set.chunks[i].n_records;
+  }
 
-    /* store it */
-    add_face(o,f);
+  if(total < o->n_vertices + o->n_faces)
+    ok = false;
+
+  /* each piece gets its own arena to put its indices in */
+  for(i = 0; ok == true && i < n_chunks; i++)
+    if((set.chunks[i].part.mem = create_arena(0)) == NULL)
+      ok = false;
+
+  if(ok == true)
+    run_pool(workers,n_chunks,parse_chunk,&set);
+
+  /* now we know how many indices each piece has, work out where they go */
+  for(total = 0, i = 0; ok == true && i < n_chunks; i++){
+    if(set.chunks[i].ok == false)
+      ok = false;
+
+    set.chunks[i].first_index = total;
+    total += set.chunks[i].part.n_indices;
+  }
+
+  if(ok == true && reserve_indices(o,total) == false)
+    ok = false;
+
+  if(ok == true) {
+    run_pool(workers,n_chunks,join_chunk,&set);
+
+    o->n_indices = total;
+    o->filled_vertices = o->n_vertices;
+    o->filled_faces = o->n_faces;
+  }
+
+  for(i = 0; i < n_chunks; i++)
+    free_arena(set.chunks[i].part.mem);
+  free(set.chunks);
+
+  return ok;
+}
+
+
+/* readFile():
+   description: does all the work. see file description
+   inputs: the object to fill, the file to read, the pool of workers to
+           read it with (or NULL to do it all on this thread) and whether to
+           use the geometry cache
+ */
+void readfile(object *o, const char *filename, pool *workers, bool cache){
+  int fd;
+  int n_vertices,n_faces,n_edges;
+  struct stat info;
+  char *data;
+  cursor c;
+
+  /* Don't bother reading it if we've done it before */
+  if(cache == true && load_cache(o,filename) == true)
+    return;
+
+  /* Attempt to open the file */
+  if((fd = open(filename,O_RDONLY)) < 0 || fstat(fd,&info) < 0){
+    fprintf(stderr,"Error: failed to open file %s\n",filename);
+    exit(1);
+  }
+
+  /* map the whole thing in, we only ever read it front to back */
+  data = NULL;
+  if(info.st_size > 0)
+    data = mmap(NULL,info.st_size,PROT_READ,MAP_PRIVATE,fd,0);
+
+  if(data == NULL || data == MAP_FAILED){
+    fprintf(stderr,"Error: failed to read file %s\n",filename);
+    exit(1);
+  }
+  madvise(data,info.st_size,MADV_SEQUENTIAL);
+  close(fd);
+
+  c.pos = data;
+  c.end = c.limit = data + info.st_size;
+
+  /* Check this is a NOFF file */
+  skip_space(&c);
+  if(c.end - c.pos < 4 || strncmp(c.pos,"NOFF",4) != 0 ||
+     (c.pos + 4 < c.end && !is_space(c.pos[4]))){
+    fprintf(stderr,"Error: file %s is not of NOFF format\n",filename);
+    exit(1);
   }
+  c.pos += 4;
 
-  /* close the file */
-  fclose(file);
+  /* read in the number of vertices, faces and edges */
+  if(!next_int(&c,&n_vertices) || !next_int(&c,&n_faces) ||
+     !next_int(&c,&n_edges)){
+    fprintf(stderr,"Error: file %s has a bad header\n",filename);
+    exit(1);
+  }
+
+  /* init the object model */
+  if(init_object(o,n_vertices,n_faces)==false){
+    fprintf(stderr,"Error: unsuccessful call to init_object\n");
+    exit(1);
+  }
+
+  /* share out the work for big files, falling back to reading it in one
+     go if the lines aren't laid out the way we expect */
+  if(workers == NULL || workers->n_threads == 1 ||
+     info.st_size < PARALLEL_SIZE ||
+     read_body_parallel(&c,o,workers) == false)
+    read_body(&c,o);
+
+  /* all done with the file */
+  munmap(data,info.st_size);
+
+  /* save the results for next time. it doesn't matter if we can't */
+  if(cache == true && save_cache(o,filename) == false) {
+#ifdef DEBUG
+    printf("unable to write the geometry cache for %s\n",filename);
+#endif
+  }
 }
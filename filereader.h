@@ -15,6 +15,6 @@
 #define DEFAULT_COLOUR 0.6
 
 /* interface function prototypes */
-void readfile(object *, const char *);
+void readfile(object *, const char *, pool *, bool);
 
 #endif /*!_CB_FILEREAD_H*/
@@ -11,23 +11,65 @@
  *     w x       - window width & height, where 'x' is the number of pixels
  *     a x       - degrees to rotate the model per frame
  *     b         - turn ON back face culling
- *     o [n|d|v] - optimisation mode. n = normal, no optimisation
+ *     o [n|d|v|s] - optimisation mode. n = normal, no optimisation
  *                                    d = use display lists
  *                                    v = use vertex arrays
+ *                                    s = use vertex arrays of triangle
+ *                                        strips (turns on -p t, m and s)
+ *                                    c = use vertex arrays, culling
+ *                                        clusters of triangles that can't
+ *                                        be seen (turns on -p t and m)
+ *                                    h = use vertex arrays, culling a
+ *                                        hierarchy of boxes around the
+ *                                        triangles against the view
+ *                                        (turns on -p t and m)
+ *                                    b = use vertex and index buffer
+ *                                        objects, uploaded to the card
+ *                                        once
+ *                                    m = use vertex arrays, drawing all
+ *                                        the faces of each colour with
+ *                                        one call
+ *                                    g = use GLSL shaders for the
+ *                                        lighting, drawing from a vertex
+ *                                        array object
+ *                                    r = draw on the cpu with the
+ *                                        software rasteriser, in tiles
+ *                                        on the worker threads
  *     t         - track ball mode. Interactive rotation of the model.
  *                 'r','f','w','a' parameters have no effect when 't'
- *                 is specified as a parameter.
+ *                 is specified as a parameter. drag with the right button,
+ *                 or press '+' and '-', to zoom.
  *
  *     c x       - clocked mode. Run for x seconds and quit, displaying
  *                 fps information.
  *     d x       - fps dump mode. Dump the fps every x seconds.
+ *     j x       - number of threads to use when loading the model (and
+ *                 drawing it with -o r).
+ *     n         - don't use (or write) the binary geometry cache.
+ *     p x       - run pass x over the model after loading it. can be given
+ *                 more than once. w = weld vertices, t = triangulate,
+ *                 m = merge faces with the same colour, c = reorder for the
+ *                 vertex cache, l = levels of detail, s = triangle strips,
+ *                 q = squash the vertices into 12 bytes for the vertex
+ *                 array modes, b = bake the face colours into the vertices
+ *     e x       - how close vertices have to be for -p w to weld them
+ *     i x       - draw x copies of the model with -o g, using instancing
+ *     --headless
+ *               - don't open a window. draw offscreen with EGL instead, at
+ *                 the -w size, so it runs without an X display. not with -t
+ *     --dump-frames dir
+ *               - save the frames drawn as .ppm files in dir
+ *     --dump-every x
+ *               - with --dump-frames, only save every x'th frame
  */
 
 #include <signal.h>
 #include <unistd.h>
+#include <getopt.h>
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "common.h"
 #include "platform.h"
@@ -35,14 +77,41 @@
 #include "vertex.h"
 #include "face.h"
 #include "object.h"
+#include "pool.h"
+#include "scan.h"
 #include "filereader.h"
+#include "triangulate.h"
+#include "vcache.h"
+#include "weld.h"
+#include "strip.h"
+#include "cluster.h"
+#include "bvh.h"
+#include "raster.h"
+#include "simplify.h"
+#include "quantise.h"
+#include "bake.h"
+#include "headless.h"
+#include "dump.h"
+#include "cache.h"
 #include "render.h"
 #include "trackball.h"
 #include "timer.h"
 
 /* options that we except from the command line
    see getopt manpage for details */
-#define opt_string "+br:o:w:f:a:tc:d:"
+#define opt_string "+br:o:w:f:a:tc:d:j:np:e:i:"
+
+/* the options with long names only, numbered after all the letters */
+#define OPT_HEADLESS 256
+#define OPT_DUMP_FRAMES 257
+#define OPT_DUMP_EVERY 258
+
+static struct option long_options[] = {
+  {"headless", no_argument, NULL, OPT_HEADLESS},
+  {"dump-frames", required_argument, NULL, OPT_DUMP_FRAMES},
+  {"dump-every", required_argument, NULL, OPT_DUMP_EVERY},
+  {NULL, 0, NULL, 0}
+};
 
 /* Default options */
 #define DEFAULT_WIDTH 400
@@ -56,24 +125,68 @@
 #define DEFAULT_CLOCK false
 #define DEFAULT_FPS_DUMP false
 
+/* 0 means use one thread per processor */
+#define DEFAULT_THREADS 0
+#define DEFAULT_CACHE true
+#define DEFAULT_PASSES 0
+#define DEFAULT_WELD_EPSILON 0.0f
+#define DEFAULT_INSTANCES 1
+#define DEFAULT_HEADLESS false
+#define DEFAULT_DUMP_DIR NULL
+#define DEFAULT_DUMP_EVERY 1
+
+/* how much the zoom changes for a key press, or dragging the height of the
+   window */
+#define ZOOM_STEP 0.1
+#define ZOOM_DRAG 2.0
+
 /* Globals for storing the current state and the configuration */
 state current;
 config options;
 renderer * r;
+dumper * frame_dumper = NULL;
 
 
+/* fps_output():
+   description: the fps alarm. render() may be half way through a frame,
+     so it only flags that the fps is due, for report_fps() to print
+ */
 void fps_output(int sig){
-  printf("FPS = %f\n",(current.last_frames / ((float)options.time_to_run)));
-  current.last_frames = 0;
+  current.stats_due = true;
 
   if(options.fps_dump)
     alarm(options.time_to_run);
   else if(options.clock) {
-    exit(0);
+    current.time_up = true;
   }
 }
 
 
+/* report_fps():
+   description: called between frames. prints the fps and the render stats
+     if the alarm has gone off since last time, and starts counting again
+ */
+void report_fps(void){
+  if(current.stats_due == false) return;
+  current.stats_due = false;
+
+  printf("FPS = %f\n",(current.last_frames / ((float)options.time_to_run)));
+  current.last_frames = 0;
+
+  /* anything else goes to stderr, benchmark.pl reads the fps */
+  print_render_stats(r);
+}
+
+
+/* finish_dump():
+   description: called at exit, saves the frames still being read back
+ */
+void finish_dump(void){
+  finish_dumper(frame_dumper);
+  frame_dumper = NULL;
+}
+
+
 /* automatic_idle:
    description: idle callback for non interactive mode. simply rotates the
      model around the desired axis and quits at the appropriate time
@@ -81,6 +194,12 @@ void fps_output(int sig){
 void automatic_idle(void){
   /*struct timeval tv;*/
 
+  report_fps();
+
+  /* the clock ran out while drawing the last frame */
+  if(current.time_up == true)
+    exit(0);
+
   /* If we've got to the end then quit unless we're running on a timeout */
   if(current.frames == options.total_frames && !options.clock) {
     /* output profiling information - time and fps */
@@ -89,6 +208,7 @@ void automatic_idle(void){
     printf("avg fps=%f\n",
            (options.total_frames /
             ( ( ((float)tv.tv_sec))+(tv.tv_usec/1000000.0f)) ) );*/
+    print_render_stats(r);
     exit(0);
   }
 
@@ -98,38 +218,52 @@ void automatic_idle(void){
   /* increase the total number of frames drawn count */
   current.frames++;
 
-  glutPostRedisplay();
+  if(options.headless == false)
+    glutPostRedisplay();
 }
 
 
 /* interactive_key:
    description: callback for trackball mode that handles keypresses.
-     For the moment it simply reacts to 'q' by quiting
+     'q' quits, '+' and '-' zoom in and out
  */
 void interactive_key(unsigned char key, int x,int y){
   if(key == 'q') exit(0);
+
+  if(key == '+' || key == '=') {
+    set_zoom(r,-ZOOM_STEP);
+    glutPostRedisplay();
+  } else if(key == '-') {
+    set_zoom(r,ZOOM_STEP);
+    glutPostRedisplay();
+  }
 }
 
 
 /* interactive_mouse:
    description: callback for trackball mode that handles mouse clicking.
-     A left click starts the rotation code.
+     A left click starts the rotation code, a right click starts zooming.
  */
 void interactive_mouse(int button,int state,int x, int y){
-  if((button == GLUT_LEFT_BUTTON) && (state == GLUT_DOWN)){
+  if((button == GLUT_LEFT_BUTTON || button == GLUT_RIGHT_BUTTON) &&
+     (state == GLUT_DOWN)){
     current.motion = true;
+    current.type = (button == GLUT_LEFT_BUTTON) ? rotate : zoom;
     current.beginx = x;
     current.beginy = y;
   }
-  if (button == GLUT_LEFT_BUTTON && state == GLUT_UP) {
+  if ((button == GLUT_LEFT_BUTTON || button == GLUT_RIGHT_BUTTON) &&
+      state == GLUT_UP) {
     current.motion = false;
+    current.type = none;
   }
 }
 
 
 /* interactive_motion:
    description: callback for trackball mode that handles movement of the mouse.
-     It updates the rotational quaternion based upon the mouse movement
+     It updates the rotational quaternion (or the zoom) based upon the mouse
+     movement
    inputs: current x and y locations of the mouse
  */
 void interactive_motion(int x,int y){
@@ -139,6 +273,15 @@ void interactive_motion(int x,int y){
   w = options.window_width;
   h = options.window_height;
 
+  /* dragging down moves the model away */
+  if(current.motion == true && current.type == zoom){
+    set_zoom(r,ZOOM_DRAG * (y - current.beginy) / h);
+    current.beginy = y;
+
+    glutPostRedisplay();
+    return;
+  }
+
   /* If were moving then update the quaternion and redisplay */
   if(current.motion == true){
     trackball(current.lastquat,
@@ -165,6 +308,7 @@ void interactive_motion(int x,int y){
    description: callback for drawing the screen. pretty much just calls render
  */
 void display(void){
+  report_fps();
   current.last_frames++;
 
   render(r);
@@ -183,12 +327,153 @@ void reshape(int width, int height){
 }
 
 
+/* run_headless():
+   description: the main loop when there's no window. does what GLUT would:
+     one reshape, then draws and moves on a frame as fast as it can until
+     automatic_idle() or the fps alarm quits
+ */
+void run_headless(void){
+  reshape(options.window_width,options.window_height);
+
+  while(true){
+    display();
+    automatic_idle();
+  }
+}
+
+
+/* preprocess():
+   description: runs the passes asked for over the model, in the order that
+     makes sense rather than the order they were given. each one prints what
+     it did and how long it took
+   inputs: the loaded model, the file it came from
+ */
+void preprocess(object *model, const char *filename){
+  double start;
+  float before;
+  strip_stats stats;
+  quantise_stats qstats;
+  bake_stats bstats;
+  unsigned int key;
+  int n;
+
+  if(options.passes & pass_weld) {
+    start = get_seconds();
+    n = model->n_vertices;
+    weld_vertices(model,options.weld_epsilon);
+    fprintf(stderr,"weld: %d vertices into %d, saving %ld bytes in %.2fms\n",
+            n,model->n_vertices,(long) sizeof(vertex) * (n - model->n_vertices),
+            (get_seconds() - start) * 1000.0);
+  }
+
+  /* triangles first, so they can all be merged together */
+  if(options.passes & pass_triangulate) {
+    start = get_seconds();
+    n = model->n_faces;
+    triangulate(model);
+    fprintf(stderr,"triangulate: %d faces into %d triangles in %.2fms\n",
+            n,model->n_faces,(get_seconds() - start) * 1000.0);
+  }
+
+  /* then the colours go onto the vertices, so merging ignores them */
+  if(options.passes & pass_bake) {
+    start = get_seconds();
+    if(bake_colours(model,&bstats) == false)
+      fprintf(stderr,"bake: not enough memory\n");
+    else
+      fprintf(stderr,"bake: %d vertices into %d (%d split off), %ld bytes of "
+              "colours in %.2fms\n",bstats.vertices_before,
+              bstats.vertices_after,
+              bstats.vertices_after - bstats.vertices_before,
+              4L * model->n_vertices,(get_seconds() - start) * 1000.0);
+  }
+
+  if(options.passes & pass_merge) {
+    start = get_seconds();
+    n = model->n_faces;
+    optimise(model);
+    fprintf(stderr,"merge: %d faces into %d batches in %.2fms\n",
+            n,model->n_faces,(get_seconds() - start) * 1000.0);
+  }
+
+  /* the triangles only go into a cache friendly order inside each face */
+  if(options.passes & pass_vcache) {
+    start = get_seconds();
+    before = acmr(model);
+    if(reorder_triangles(model) == false || reorder_vertices(model) == false)
+      fprintf(stderr,"vcache: not enough memory\n");
+    else
+      fprintf(stderr,"vcache: ACMR %.3f -> %.3f (%d entry FIFO) in %.2fms\n",
+              before,acmr(model),VCACHE_SIZE,
+              (get_seconds() - start) * 1000.0);
+  }
+
+  /* the levels of detail are cached, keyed on everything that came before
+     that could have changed the model */
+  if(options.passes & pass_lod) {
+    start = get_seconds();
+    memcpy(&key,&options.weld_epsilon,sizeof(key));
+    key = (key * 31) ^ (options.passes & ~(pass_strip | pass_quantise));
+
+    if(options.cache && load_lod_cache(model,filename,key))
+      fprintf(stderr,"lod: loaded from the cache");
+    else if(build_lods(model) == false)
+      fprintf(stderr,"lod: not enough memory\n");
+    else {
+      fprintf(stderr,"lod: built");
+      if(options.cache)
+        save_lod_cache(model,filename,key);
+    }
+
+    if(model->n_lods > 0) {
+      for(n = 0; n < model->n_lods; n++)
+        fprintf(stderr,"%s%d",n ? ", " : " levels of ",
+                model->lods[n].n_indices / 3);
+      fprintf(stderr," triangles in %.2fms\n",
+              (get_seconds() - start) * 1000.0);
+    }
+  }
+
+  /* strips are made from the triangles in each face, last of all */
+  if(options.passes & pass_strip) {
+    start = get_seconds();
+    if(stripify(model,&stats) == false)
+      fprintf(stderr,"strip: not enough memory\n");
+    else
+      fprintf(stderr,"strip: %d triangles into %d strips (%.1f average, %d "
+              "longest), %d -> %d indices in %.2fms\n",stats.n_triangles,
+              stats.n_strips,stats.n_strips > 0 ?
+              (float) stats.n_triangles / stats.n_strips : 0.0f,
+              stats.longest,stats.indices_before,stats.indices_after,
+              (get_seconds() - start) * 1000.0);
+  }
+
+  /* the vertices don't change after this, so they can be squashed */
+  if(options.passes & pass_quantise) {
+    start = get_seconds();
+    if(quantise_vertices(model,&qstats) == false)
+      fprintf(stderr,"quantise: not enough memory\n");
+    else
+      fprintf(stderr,"quantise: %d vertices, %ld -> %ld bytes, moved at most "
+              "%g in %.2fms\n",model->n_vertices,qstats.bytes_before,
+              qstats.bytes_after,qstats.error,
+              (get_seconds() - start) * 1000.0);
+  }
+}
+
+
 /**********************
  *** MAIN function  ***
  **********************/
 int main(int argc, char *argv[]) {
   int option=0;
   object model;
+  pool *workers;
+  cluster *clusters;
+  bvh *tree;
+  raster *rasteriser;
+  int n_clusters;
+  double start;
 
   /* Setup the defaults */
   options.back_cull = DEFAULT_BACKFACECULL;
@@ -201,12 +486,30 @@ int main(int argc, char *argv[]) {
   options.type = DEFAULT_RENDERTYPE;
   options.clock = DEFAULT_CLOCK;
   options.fps_dump = DEFAULT_FPS_DUMP;
-
-  glutInit(&argc,argv);
+  options.threads = DEFAULT_THREADS;
+  options.cache = DEFAULT_CACHE;
+  options.passes = DEFAULT_PASSES;
+  options.weld_epsilon = DEFAULT_WELD_EPSILON;
+  options.instances = DEFAULT_INSTANCES;
+  options.headless = DEFAULT_HEADLESS;
+  options.dump_dir = DEFAULT_DUMP_DIR;
+  options.dump_every = DEFAULT_DUMP_EVERY;
+  current.stats_due = false;
+  current.time_up = false;
+
+  /* GLUT needs a display, so it's left alone when there isn't one. it
+     takes its own options out of argv, so this has to happen first */
+  for(option = 1; option < argc; option++)
+    if(strcmp(argv[option],"--headless") == 0)
+      options.headless = true;
+  option = 0;
+
+  if(options.headless == false)
+    glutInit(&argc,argv);
 
   /* Parse the arguments */
   while(option!=-1){
-    option = getopt(argc,argv,opt_string);
+    option = getopt_long(argc,argv,opt_string,long_options,NULL);
 
     switch (option){
       case 'b': /* back face cull */
@@ -239,6 +542,27 @@ int main(int argc, char *argv[]) {
           case 'v':
             options.type = vertex_array;
             break;
+          case 's':
+            options.type = strip;
+            break;
+          case 'c':
+            options.type = clustered;
+            break;
+          case 'h':
+            options.type = hierarchy;
+            break;
+          case 'b':
+            options.type = buffer_object;
+            break;
+          case 'm':
+            options.type = multi_draw;
+            break;
+          case 'g':
+            options.type = shader_program;
+            break;
+          case 'r':
+            options.type = software;
+            break;
           default:
             fprintf(stderr,"Error: invalid option for o\n");
             exit(1);
@@ -302,6 +626,90 @@ int main(int argc, char *argv[]) {
 
         break;
 
+      case 'j': /* number of threads */
+        options.threads = atoi(optarg);
+
+        if(options.threads <= 0) {
+          fprintf(stderr,
+            "Error: please specify a positive integer for threads\n");
+          exit(1);
+        }
+        break;
+
+      case 'n': /* no geometry cache */
+        options.cache = false;
+        break;
+
+      case 'e': /* weld epsilon */
+        options.weld_epsilon = atof(optarg);
+
+        if(options.weld_epsilon < 0) {
+          fprintf(stderr,
+            "Error: please specify a positive number for epsilon\n");
+          exit(1);
+        }
+        break;
+
+      case 'i': /* copies of the model for the shaders to draw */
+        options.instances = atoi(optarg);
+
+        if(options.instances < 1) {
+          fprintf(stderr,
+            "Error: please specify a positive integer for instances\n");
+          exit(1);
+        }
+        break;
+
+      case OPT_HEADLESS: /* no window, seen before glutInit() */
+        options.headless = true;
+        break;
+
+      case OPT_DUMP_FRAMES: /* where to save the frames */
+        options.dump_dir = optarg;
+        break;
+
+      case OPT_DUMP_EVERY: /* how often to save a frame */
+        options.dump_every = atoi(optarg);
+
+        if(options.dump_every < 1) {
+          fprintf(stderr,
+            "Error: please specify a positive integer for dump every\n");
+          exit(1);
+        }
+        break;
+
+      case 'p': /* preprocessing pass */
+        switch (optarg[0]){
+          case 't':
+            options.passes |= pass_triangulate;
+            break;
+          case 'm':
+            options.passes |= pass_merge;
+            break;
+          case 'c':
+            options.passes |= pass_vcache;
+            break;
+          case 'w':
+            options.passes |= pass_weld;
+            break;
+          case 's':
+            options.passes |= pass_strip;
+            break;
+          case 'l':
+            options.passes |= pass_lod;
+            break;
+          case 'q':
+            options.passes |= pass_quantise;
+            break;
+          case 'b':
+            options.passes |= pass_bake;
+            break;
+          default:
+            fprintf(stderr,"Error: invalid option for p\n");
+            exit(1);
+        }
+        break;
+
     }
   }
   /* Attempt to get the filename index in argv */
@@ -321,24 +729,118 @@ int main(int argc, char *argv[]) {
   printf("total frames = %d\n",options.total_frames);
   printf("rotation rate = %d\n",options.rotation_rate);
   printf("render type = %d\n",options.type);
+  printf("threads = %d\n",options.threads);
+  printf("passes = %d\n",options.passes);
+  printf("weld epsilon = %f\n",options.weld_epsilon);
   printf("filename = %s\n",argv[option]);
 #endif
 
-  /* Load the model from specified file */
-  readfile(&model,argv[option]);
+  /* there's no mouse to drag without a window */
+  if(options.headless && options.trackball){
+    fprintf(stderr,"Error: --headless can't be used with -t\n");
+    exit(1);
+  }
+
+  /* strips need the model in triangles, merged so the strips can be long */
+  if(options.type == strip)
+    options.passes |= pass_triangulate | pass_merge | pass_strip;
+
+  /* and so are levels of detail */
+  if(options.passes & pass_lod)
+    options.passes |= pass_triangulate;
+
+  /* clusters and the hierarchy are made of triangles */
+  if(options.type == clustered || options.type == hierarchy)
+    options.passes |= pass_triangulate | pass_merge;
 
-  /* Setup the output with GLUT */
-  glutInitWindowSize(options.window_width,options.window_height);
-  glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
-  glutCreateWindow("GLOffView");
+  /* Start up the worker threads */
+  if(options.threads == 0)
+    options.threads = default_threads();
+
+  if((workers = create_pool(options.threads)) == NULL){
+    fprintf(stderr,"Error: unable to create worker threads\n");
+    exit(1);
+  }
+
+  /* Load the model from specified file, with the fastest text scanner */
+  set_scan_mode(scan_auto);
+  readfile(&model,argv[option],workers,options.cache);
+  preprocess(&model,argv[option]);
+
+  /* Setup the output with GLUT, or offscreen */
+  if(options.headless) {
+    if(!create_headless(options.window_width,options.window_height)){
+      fprintf(stderr,"Error: unable to create an offscreen GL context\n");
+      exit(1);
+    }
+  } else {
+    glutInitWindowSize(options.window_width,options.window_height);
+    glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB | GLUT_DEPTH);
+    glutCreateWindow("GLOffView");
+  }
 
   /* Initalise the render */
   r = init_render(&model,options.back_cull,options.type,
               options.window_width,options.window_height);
+  set_instances(r,options.instances);
+  set_headless(r,options.headless);
+
+  if(options.dump_dir != NULL) {
+    if((frame_dumper = create_dumper(options.dump_dir,
+                                     options.dump_every)) == NULL){
+      fprintf(stderr,"Error: unable to save frames in %s\n",
+              options.dump_dir);
+      exit(1);
+    }
+    set_dumper(r,frame_dumper);
+    atexit(finish_dump);
+  }
+
+  if(options.type == clustered) {
+    start = get_seconds();
+    if((clusters = build_clusters(&model,workers,&n_clusters)) == NULL){
+      fprintf(stderr,"Error: unable to allocate memory for clusters\n");
+      exit(1);
+    }
+    fprintf(stderr,"clusters: %d faces into %d clusters in %.2fms\n",
+            model.n_faces,n_clusters,(get_seconds() - start) * 1000.0);
+    set_clusters(r,clusters,n_clusters);
+  }
+
+  if(options.type == software) {
+    if((rasteriser = create_raster(&model,workers)) == NULL){
+      fprintf(stderr,"Error: unable to allocate memory for the software "
+              "rasteriser\n");
+      exit(1);
+    }
+    set_raster(r,rasteriser);
+  }
+
+  if(options.type == hierarchy) {
+    start = get_seconds();
+    if((tree = build_bvh(&model,workers)) == NULL){
+      fprintf(stderr,"Error: unable to allocate memory for the hierarchy\n");
+      exit(1);
+    }
+    fprintf(stderr,"bvh: %d nodes, %d leaves over %d faces in %.2fms\n",
+            tree->n_nodes,tree->n_leaves,model.n_faces,
+            (get_seconds() - start) * 1000.0);
+    set_bvh(r,tree);
+  }
+
+  /* the vertex array modes draw from indices as small as they can be */
+  if(r->index_bytes_before > 0)
+    fprintf(stderr,"indices: %d vertices fit %d byte indices, %ld -> %ld "
+            "bytes\n",model.n_vertices,r->index_size,r->index_bytes_before,
+            r->index_bytes_after);
+  if(options.type == buffer_object)
+    fprintf(stderr,"buffers: %ld bytes uploaded\n",r->buffer_bytes);
 
   /* Setup common callback functions */
-  glutDisplayFunc(display);
-  glutReshapeFunc(reshape);
+  if(options.headless == false) {
+    glutDisplayFunc(display);
+    glutReshapeFunc(reshape);
+  }
 
   /* setup fps output signal if specified */
   if(options.fps_dump || options.clock){
@@ -364,6 +866,9 @@ int main(int argc, char *argv[]) {
 
     set_quaternion(r, current.curquat);
 
+  } else if(options.headless) {
+    current.frames = 0;
+
   } else {
     current.frames = 0;
     glutIdleFunc(automatic_idle);
@@ -373,7 +878,10 @@ int main(int argc, char *argv[]) {
 
   /* start the timer and go -> */
   /*restart_timer();*/
-  glutMainLoop();
+  if(options.headless)
+    run_headless();
+  else
+    glutMainLoop();
 
   return 0;
 }
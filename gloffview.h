@@ -11,10 +11,18 @@
 #ifndef _CB_GLOFFVIEW_H
 #define _CB_GLOFFVIEW_H
 
+#include <signal.h> /*for sig_atomic_t*/
+
 #include "common.h"
 
 typedef enum { none , rotate, zoom } motion;
 
+/* the passes that can be run over the model once it's loaded. they are
+   bits, so more than one can be asked for */
+typedef enum { pass_merge = 1, pass_triangulate = 2, pass_vcache = 4,
+               pass_weld = 8, pass_strip = 16, pass_lod = 32,
+               pass_quantise = 64, pass_bake = 128 } pass;
+
 /* state struct. for representing the current state */
 typedef struct {
   /* values for dealing with interactive rotation */
@@ -31,6 +39,11 @@ typedef struct {
   int  frames;
   axis   rot_axis;
   long int  last_frames;
+
+  /* set by the fps alarm, so the fps and stats are printed between frames
+     and the main loop quits between frames when the clock runs out */
+  volatile sig_atomic_t stats_due;
+  volatile sig_atomic_t time_up;
 } state;
 
 /* config struct. for represent the program configuration */
@@ -40,12 +53,20 @@ typedef struct {
   bool trackball;
   bool clock;
   bool fps_dump;
+  bool cache;
   axis rotate_axis;
   int  rotation_rate;
   int  total_frames;
   int  window_width;
   int  window_height;
   int  time_to_run;
+  int  threads;
+  int  passes;
+  float weld_epsilon;
+  int  instances;
+  bool headless;
+  char *dump_dir;
+  int  dump_every;
 } config;
 
 #endif /* !_CB_GLOFFVIEW_H */
@@ -0,0 +1,167 @@
+/********************
+ * FILE: glstate.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     A thin layer between the renderer and GL that remembers the state it
+ *     last set, and skips calls that wouldn't change anything. Capabilities,
+ *     the current colour and the light and material parameters go through
+ *     it. It counts the calls it sends and skips, so the stats can show
+ *     how much per frame work was saved.
+ *
+ *     Anything that changes the same state behind its back (a display list,
+ *     or a colour array) has to say so with state_forget_colour().
+ */
+
+#include <string.h> /*for memcpy*/
+
+#include "common.h"
+#include "platform.h"
+#include "glstate.h"
+
+
+/* init_state():
+   description: forgets everything, so the next call for each piece of
+                state is always sent, and clears the counts
+ */
+void init_state(gl_state *s){
+  s->n_caps = 0;
+  s->n_params = 0;
+  s->colour_known = false;
+  s->calls = 0;
+  s->skipped = 0;
+}
+
+
+/* state_enable():
+   description: enables or disables a capability, unless it already is
+   inputs: the state, the capability, true to enable it
+ */
+void state_enable(gl_state *s, GLenum cap, bool on){
+  int i;
+
+  for(i = 0; i < s->n_caps && s->caps[i] != cap; i++);
+
+  if(i < s->n_caps && s->enabled[i] == on) {
+    s->skipped++;
+    return;
+  }
+
+  /* remember it, if there's room */
+  if(i < STATE_CAPS) {
+    s->caps[i] = cap;
+    s->enabled[i] = on;
+    if(i == s->n_caps)
+      s->n_caps++;
+  }
+
+  if(on == true)
+    glEnable(cap);
+  else
+    glDisable(cap);
+  s->calls++;
+}
+
+
+/* state_colour():
+   description: sets the current colour, unless it already is
+ */
+void state_colour(gl_state *s, float r, float g, float b){
+  if(s->colour_known == true && s->colour[0] == r && s->colour[1] == g &&
+     s->colour[2] == b) {
+    s->skipped++;
+    return;
+  }
+
+  s->colour[0] = r;
+  s->colour[1] = g;
+  s->colour[2] = b;
+  s->colour_known = true;
+
+  glColor3f(r,g,b);
+  s->calls++;
+}
+
+
+/* state_forget_colour():
+   description: says the current colour has been changed by something
+                else, so the next colour is always sent
+ */
+void state_forget_colour(gl_state *s){
+  s->colour_known = false;
+}
+
+
+/* same_param():
+   description: checks a parameter against the last value it was set to,
+                and remembers the new one (if there's room)
+   inputs: the state, what the parameter belongs to, its name, its values
+           and how many there are
+   output: true if it's the same as last time, so needn't be sent
+ */
+static bool same_param(gl_state *s, GLenum what, GLenum pname,
+                       const float *v, int n){
+  state_param *p;
+  int i;
+
+  for(i = 0; i < s->n_params; i++){
+    p = s->params + i;
+    if(p->what == what && p->pname == pname)
+      break;
+  }
+
+  if(i < s->n_params && p->n_values == n &&
+     memcmp(p->values,v,sizeof(float) * n) == 0) {
+    s->skipped++;
+    return true;
+  }
+
+  if(i < STATE_PARAMS) {
+    p = s->params + i;
+    p->what = what;
+    p->pname = pname;
+    p->n_values = n;
+    memcpy(p->values,v,sizeof(float) * n);
+    if(i == s->n_params)
+      s->n_params++;
+  }
+
+  s->calls++;
+  return false;
+}
+
+
+/* state_light():
+   description: sets a parameter of a light, unless it already is. GL
+                moves a light's position by the modelview matrix when it's
+                set, so a position is only safe to skip for a directional
+                light under a modelview that doesn't turn
+   inputs: the state, the light, the parameter and its 4 values
+ */
+void state_light(gl_state *s, GLenum light, GLenum pname, const float *v){
+  if(same_param(s,light,pname,v,4) == false)
+    glLightfv(light,pname,v);
+}
+
+
+/* state_light_model():
+   description: sets a parameter of the light model, unless it already is
+   inputs: the state, the parameter and its 4 values
+ */
+void state_light_model(gl_state *s, GLenum pname, const float *v){
+  if(same_param(s,0,pname,v,4) == false)
+    glLightModelfv(pname,v);
+}
+
+
+/* state_material():
+   description: sets a material parameter, unless it already is
+   inputs: the state, the face, the parameter, its values and how many
+           there are (1 for the shininess, otherwise 4)
+ */
+void state_material(gl_state *s, GLenum face, GLenum pname, const float *v,
+                    int n){
+  if(same_param(s,face,pname,v,n) == false)
+    glMaterialfv(face,pname,v);
+}
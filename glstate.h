@@ -0,0 +1,55 @@
+/********************
+ * FILE: glstate.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for glstate.c. Defines what GL state is remembered and
+ *     contains the prototypes for the interface functions
+ */
+
+#ifndef _CB_GLSTATE_H
+#define _CB_GLSTATE_H
+
+#include "common.h"
+#include "platform.h"
+
+/* how many capabilities and light/material parameters can be remembered */
+#define STATE_CAPS 8
+#define STATE_PARAMS 8
+
+/* a light, material or light model parameter and what it was set to. what
+   is the light, the material's face, or 0 for the light model */
+typedef struct {
+  GLenum what;
+  GLenum pname;
+  int n_values;
+  float values[4];
+} state_param;
+
+/* the state last sent to GL, and how many calls were sent or skipped
+   since the counts were last cleared */
+typedef struct {
+  GLenum caps[STATE_CAPS];
+  bool enabled[STATE_CAPS];
+  int n_caps;
+
+  state_param params[STATE_PARAMS];
+  int n_params;
+
+  bool colour_known;
+  float colour[3];
+
+  long calls;
+  long skipped;
+} gl_state;
+
+/* interface function prototypes */
+void init_state(gl_state *);
+void state_enable(gl_state *,GLenum,bool);
+void state_colour(gl_state *,float,float,float);
+void state_forget_colour(gl_state *);
+void state_light(gl_state *,GLenum,GLenum,const float *);
+void state_light_model(gl_state *,GLenum,const float *);
+void state_material(gl_state *,GLenum,GLenum,const float *,int);
+#endif /* !_CB_GLSTATE_H */
@@ -0,0 +1,102 @@
+/********************
+ * FILE: headless.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Functions for drawing without a window or a display, for running the
+ *     benchmarks on machines with no X server. An offscreen GL context is
+ *     made with EGL, drawing into a pbuffer the size the window would have
+ *     been. Mesa's surfaceless platform is used when EGL has it, so not
+ *     even a graphics card is needed (llvmpipe does the drawing).
+ */
+
+#include <stdio.h>
+#include <string.h> /*for strstr*/
+
+#include "common.h"
+#include "headless.h"
+
+#ifndef __APPLE__
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+
+#ifndef __APPLE__
+
+/* headless_display():
+   description: opens the EGL display, the surfaceless one if there is one
+   output: the display, or EGL_NO_DISPLAY
+ */
+static EGLDisplay headless_display(void){
+  PFNEGLGETPLATFORMDISPLAYEXTPROC get_platform_display;
+  const char *extensions;
+
+  extensions = eglQueryString(EGL_NO_DISPLAY,EGL_EXTENSIONS);
+
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+  if(extensions != NULL &&
+     strstr(extensions,"EGL_MESA_platform_surfaceless") != NULL) {
+    get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)
+      eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if(get_platform_display != NULL)
+      return get_platform_display(EGL_PLATFORM_SURFACELESS_MESA,
+                                  EGL_DEFAULT_DISPLAY,NULL);
+  }
+#endif
+
+  return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+}
+
+
+/* create_headless():
+   description: makes an offscreen GL context drawing into a pbuffer, with
+                the same colour and depth bits glutInitDisplayMode() asks
+                for, and makes it current
+   inputs: the width and height
+   output: false if there's no EGL or it can't make the context
+ */
+bool create_headless(int w, int h){
+  EGLint config_attribs[] = {EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+                             EGL_RED_SIZE, 8,
+                             EGL_GREEN_SIZE, 8,
+                             EGL_BLUE_SIZE, 8,
+                             EGL_DEPTH_SIZE, 24,
+                             EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+                             EGL_NONE};
+  EGLint pbuffer_attribs[] = {EGL_WIDTH, w, EGL_HEIGHT, h, EGL_NONE};
+  EGLDisplay display;
+  EGLConfig config;
+  EGLContext context;
+  EGLSurface surface;
+  EGLint major, minor, n_configs;
+
+  display = headless_display();
+  if(display == EGL_NO_DISPLAY || !eglInitialize(display,&major,&minor))
+    return false;
+
+  if(!eglBindAPI(EGL_OPENGL_API) ||
+     !eglChooseConfig(display,config_attribs,&config,1,&n_configs) ||
+     n_configs < 1)
+    return false;
+
+  context = eglCreateContext(display,config,EGL_NO_CONTEXT,NULL);
+  if(context == EGL_NO_CONTEXT) return false;
+
+  surface = eglCreatePbufferSurface(display,config,pbuffer_attribs);
+  if(surface == EGL_NO_SURFACE) return false;
+
+  return eglMakeCurrent(display,surface,surface,context) ? true : false;
+}
+
+#else
+
+/* create_headless():
+   description: there's no EGL on OS X
+ */
+bool create_headless(int w, int h){
+  return false;
+}
+
+#endif
@@ -0,0 +1,18 @@
+/********************
+ * FILE: headless.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for headless.c. Contains the prototypes for the interface
+ *     functions
+ */
+
+#ifndef _CB_HEADLESS_H
+#define _CB_HEADLESS_H
+
+#include "common.h"
+
+/* interface function prototypes */
+bool create_headless(int,int);
+#endif /* !_CB_HEADLESS_H */
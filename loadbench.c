@@ -0,0 +1,209 @@
+/********************
+ * FILE: loadbench.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     loadbench times how fast .off files are loaded with each of the text
+ *     scanners the cpu supports, and prints the results in MB/s. The first
+ *     row is the original fscanf() loader, which the speedups are against.
+ * PARAMETERS:
+ *     n x       - number of times to load each file, the best is kept
+ *     j x       - number of threads to load with
+ */
+
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "common.h"
+#include "object.h"
+#include "face.h"
+#include "vertex.h"
+#include "pool.h"
+#include "scan.h"
+#include "filereader.h"
+#include "timer.h"
+
+#define opt_string "n:j:"
+
+#define DEFAULT_RUNS 20
+#define DEFAULT_THREADS 1
+
+/* read_stdio():
+   description: the loader as it was before it memory mapped the file,
+                reading everything with fscanf(). kept as the baseline
+   inputs: the object to fill, the file to read
+ */
+void read_stdio(object *o, const char *filename){
+  int i,j,in;
+  int n_vertices,n_faces,n_indices,*indices;
+  vertex v;
+  face f;
+  FILE *file;
+  char str[1024];
+
+  /* Attempt to open the file */
+  if((file = fopen(filename,"r"))==NULL){
+    fprintf(stderr,"Error: failed to open file %s\n",filename);
+    exit(1);
+  }
+
+  /* Check this is a NOFF file */
+  if(fscanf(file,"%1023s",str) != 1 || strcmp(str,"NOFF")!=0){
+    fprintf(stderr,"Error: file %s is not of NOFF format\n",filename);
+    exit(1);
+  }
+
+  /* read in the number of vertices, faces and edges */
+  if(fscanf(file,"%d %d %*d",&n_vertices,&n_faces) != 2 ||
+     init_object(o,n_vertices,n_faces)==false){
+    fprintf(stderr,"Error: unsuccessful call to init_object\n");
+    exit(1);
+  }
+
+  /* load all the vertices */
+  for(i = 0; i < o->n_vertices; i++) {
+    if(fscanf(file,"%f %f %f %f %f %f",&(v.x),&(v.y),&(v.z),
+              &(v.normX),&(v.normY),&(v.normZ)) != 6)
+      v.x = v.y = v.z = v.normX = v.normY = v.normZ = 0;
+    add_vertex(o,v);
+  }
+
+  /* load all the faces */
+  for(i = 0; i < o->n_faces; i++) {
+    if(fscanf(file,"%d",&n_indices) != 1)
+      n_indices = 0;
+
+    if(init_face(&f,n_indices)==false || (indices = add_indices(o,&f))==NULL){
+      fprintf(stderr,"Error: unsuccessful call to init_face\n");
+      exit(1);
+    }
+
+    for(j=0; j < n_indices ; j++)
+      if(fscanf(file,"%d",indices + j) != 1)
+        indices[j] = 0;
+
+    /* grab the rest of the line*/
+    if(fgets(str,1024,file) == NULL)
+      str[0] = '\0';
+
+    /* zero the alpha value*/
+    f.colour[3]=0;
+
+    /* try and load the colours */
+    in = sscanf(str,"%f %f %f %f",
+               &f.colour[0],&f.colour[1],&f.colour[2],&f.colour[3]);
+
+    /* if we didn't load any colours set the red value to the default */
+    if(in <= 0) {
+      f.colour[0] = DEFAULT_COLOUR;
+      in=1;
+    }
+
+    /* set all the others to the first if only 1 value */
+    for(;in<3;in++)
+      f.colour[in] = f.colour[0];
+
+    add_face(o,f);
+  }
+
+  fclose(file);
+}
+
+
+/* bench():
+   description: loads a file over and over and works out the best time
+   inputs: the file, the number of runs, the worker pool (or NULL to use
+           read_stdio())
+   output: the best time in seconds
+ */
+double bench(const char *filename, int runs, pool *workers){
+  object model;
+  double start, taken, best = -1;
+  int i;
+
+  for(i = 0; i < runs; i++){
+    start = get_seconds();
+    if(workers == NULL)
+      read_stdio(&model,filename);
+    else
+      readfile(&model,filename,workers,false);
+    free_object(&model);
+    taken = get_seconds() - start;
+
+    if(best < 0 || taken < best)
+      best = taken;
+  }
+
+  return best;
+}
+
+
+/**********************
+ *** MAIN function  ***
+ **********************/
+int main(int argc, char *argv[]) {
+  scan_mode modes[] = { scan_scalar, scan_sse2, scan_avx2 };
+  int option, runs = DEFAULT_RUNS, threads = DEFAULT_THREADS;
+  int i,m;
+  double mb,best,base;
+  struct stat info;
+  pool *workers;
+
+  while((option = getopt(argc,argv,opt_string)) != -1){
+    switch(option){
+      case 'n':
+        runs = atoi(optarg);
+        break;
+      case 'j':
+        threads = atoi(optarg);
+        break;
+      default:
+        fprintf(stderr,"usage: %s [-n runs] [-j threads] file...\n",argv[0]);
+        exit(1);
+    }
+  }
+
+  if(optind == argc || runs < 1 || threads < 1){
+    fprintf(stderr,"usage: %s [-n runs] [-j threads] file...\n",argv[0]);
+    exit(1);
+  }
+
+  workers = create_pool(threads);
+
+  printf("%-24s %-7s %10s %10s %8s\n","file","scanner","ms","MB/s","speedup");
+
+  for(i = optind; i < argc; i++){
+    if(stat(argv[i],&info) < 0){
+      fprintf(stderr,"Error: failed to open file %s\n",argv[i]);
+      continue;
+    }
+    mb = info.st_size / (1024.0 * 1024.0);
+
+    /* throw one away to get the file into the page cache */
+    bench(argv[i],1,NULL);
+    base = bench(argv[i],runs,NULL);
+
+    printf("%-24s %-7s %10.2f %10.1f %7.2fx\n",argv[i],"fscanf",
+           base * 1000.0,mb / base,1.0);
+
+    for(m = 0; m < sizeof(modes) / sizeof(modes[0]); m++){
+      if(set_scan_mode(modes[m]) == false)
+        continue;
+
+      /* throw one away to get the file into the page cache */
+      bench(argv[i],1,workers);
+      best = bench(argv[i],runs,workers);
+
+      printf("%-24s %-7s %10.2f %10.1f %7.2fx\n",argv[i],
+             scan_mode_name(modes[m]),best * 1000.0,mb / best,base / best);
+    }
+  }
+
+  free_pool(workers);
+
+  return 0;
+}
@@ -0,0 +1,176 @@
+/********************
+ * FILE: matrix.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     4x4 matrix and quaternion functions, so the whole model transform can
+ *     be worked out on the cpu and handed to GL in one go, rather than
+ *     built up with GL calls (or read back from GL). They do what the GL
+ *     and GLU functions of the same sort do: each one multiplies the
+ *     matrix it's given on the right. Multiplying is done a column at a
+ *     time with SSE where the cpu has it.
+ */
+
+#include <string.h> /*for memcpy*/
+#include <math.h> /*for sinf, cosf*/
+
+#include "matrix.h"
+
+#if defined(__GNUC__) && defined(__SSE__)
+#define MATRIX_SSE
+#include <xmmintrin.h>
+#endif
+
+
+/* mat_identity():
+   description: sets a matrix to the identity
+ */
+void mat_identity(float *m){
+  int i;
+
+  for(i = 0; i < 16; i++)
+    m[i] = (i % 5 == 0) ? 1.0f : 0.0f;
+}
+
+
+/* mat_multiply():
+   description: multiplies two matrices, like glMultMatrixf. the result can
+                be either of them
+   inputs: where to put a * b, a, b
+ */
+void mat_multiply(float *dst, const float *a, const float *b){
+  float result[16];
+  int j;
+#ifdef MATRIX_SSE
+  __m128 c0 = _mm_loadu_ps(a), c1 = _mm_loadu_ps(a + 4);
+  __m128 c2 = _mm_loadu_ps(a + 8), c3 = _mm_loadu_ps(a + 12), col;
+
+  /* each column of the result is the columns of a weighted by a column
+     of b */
+  for(j = 0; j < 4; j++){
+    col = _mm_mul_ps(c0,_mm_set1_ps(b[4 * j]));
+    col = _mm_add_ps(col,_mm_mul_ps(c1,_mm_set1_ps(b[4 * j + 1])));
+    col = _mm_add_ps(col,_mm_mul_ps(c2,_mm_set1_ps(b[4 * j + 2])));
+    col = _mm_add_ps(col,_mm_mul_ps(c3,_mm_set1_ps(b[4 * j + 3])));
+    _mm_storeu_ps(result + 4 * j,col);
+  }
+#else
+  int i;
+
+  for(j = 0; j < 4; j++)
+    for(i = 0; i < 4; i++)
+      result[4 * j + i] = a[i] * b[4 * j] + a[4 + i] * b[4 * j + 1] +
+                          a[8 + i] * b[4 * j + 2] + a[12 + i] * b[4 * j + 3];
+#endif
+
+  memcpy(dst,result,sizeof(result));
+}
+
+
+/* mat_translate():
+   description: moves a matrix, like glTranslatef
+ */
+void mat_translate(float *m, float x, float y, float z){
+  int i;
+
+  for(i = 0; i < 4; i++)
+    m[12 + i] += m[i] * x + m[4 + i] * y + m[8 + i] * z;
+}
+
+
+/* mat_scale():
+   description: scales a matrix, like glScalef
+ */
+void mat_scale(float *m, float x, float y, float z){
+  int i;
+
+  for(i = 0; i < 4; i++){
+    m[i] *= x;
+    m[4 + i] *= y;
+    m[8 + i] *= z;
+  }
+}
+
+
+/* mat_rotate():
+   description: rotates a matrix, like glRotatef
+   inputs: the matrix, the angle in degrees, the axis to turn around
+ */
+void mat_rotate(float *m, float angle, float x, float y, float z){
+  float r[16], c, s, t, length;
+
+  length = sqrtf(x * x + y * y + z * z);
+  if(length == 0.0f) return;
+  x /= length;
+  y /= length;
+  z /= length;
+
+  c = cosf(angle * (float) M_PI / 180.0f);
+  s = sinf(angle * (float) M_PI / 180.0f);
+  t = 1.0f - c;
+
+  r[0] = x * x * t + c;
+  r[1] = y * x * t + z * s;
+  r[2] = x * z * t - y * s;
+  r[3] = 0.0f;
+
+  r[4] = x * y * t - z * s;
+  r[5] = y * y * t + c;
+  r[6] = y * z * t + x * s;
+  r[7] = 0.0f;
+
+  r[8] = x * z * t + y * s;
+  r[9] = y * z * t - x * s;
+  r[10] = z * z * t + c;
+  r[11] = 0.0f;
+
+  r[12] = r[13] = r[14] = 0.0f;
+  r[15] = 1.0f;
+
+  mat_multiply(m,m,r);
+}
+
+
+/* mat_perspective():
+   description: sets a matrix to a perspective projection, like
+                gluPerspective (which multiplies rather than sets)
+   inputs: the matrix, the field of view up and down in degrees, the
+           width over the height, the near and far clipping planes
+ */
+void mat_perspective(float *m, float fovy, float aspect, float near,
+                     float far){
+  float f = 1.0f / tanf(fovy * (float) M_PI / 360.0f);
+
+  memset(m,0,sizeof(float) * 16);
+  m[0] = f / aspect;
+  m[5] = f;
+  m[10] = (far + near) / (near - far);
+  m[11] = -1.0f;
+  m[14] = 2.0f * far * near / (near - far);
+}
+
+
+/* quat_to_matrix():
+   description: sets a matrix to the rotation of a quaternion, the same
+                one build_rotmatrix() in trackball.c makes
+ */
+void quat_to_matrix(float *m, const float *q){
+  m[0] = 1.0f - 2.0f * (q[1] * q[1] + q[2] * q[2]);
+  m[1] = 2.0f * (q[0] * q[1] - q[2] * q[3]);
+  m[2] = 2.0f * (q[2] * q[0] + q[1] * q[3]);
+  m[3] = 0.0f;
+
+  m[4] = 2.0f * (q[0] * q[1] + q[2] * q[3]);
+  m[5] = 1.0f - 2.0f * (q[2] * q[2] + q[0] * q[0]);
+  m[6] = 2.0f * (q[1] * q[2] - q[0] * q[3]);
+  m[7] = 0.0f;
+
+  m[8] = 2.0f * (q[2] * q[0] - q[1] * q[3]);
+  m[9] = 2.0f * (q[1] * q[2] + q[0] * q[3]);
+  m[10] = 1.0f - 2.0f * (q[1] * q[1] + q[0] * q[0]);
+  m[11] = 0.0f;
+
+  m[12] = m[13] = m[14] = 0.0f;
+  m[15] = 1.0f;
+}
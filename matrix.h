@@ -0,0 +1,23 @@
+/********************
+ * FILE: matrix.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for matrix.c. Contains the prototypes for the interface
+ *     functions. Matrices are 16 floats, a column at a time, the same as
+ *     GL keeps them
+ */
+
+#ifndef _CB_MATRIX_H
+#define _CB_MATRIX_H
+
+/* interface function prototypes */
+void mat_identity(float *);
+void mat_multiply(float *,const float *,const float *);
+void mat_translate(float *,float,float,float);
+void mat_scale(float *,float,float,float);
+void mat_rotate(float *,float,float,float,float);
+void mat_perspective(float *,float,float,float,float);
+void quat_to_matrix(float *,const float *);
+#endif /* !_CB_MATRIX_H */
@@ -7,16 +7,24 @@
  *     Functions for handling the 'object' structure, such as initialisation,
  *     and the addition of vertices.
  */
-#include <stdlib.h> /*for free()*/
+#include <stdlib.h> /*for malloc()*/
+#include <string.h> /*for memcpy()*/
+#include <sys/mman.h> /*for munmap()*/
 
 #include "common.h"
+#include "arena.h"
 #include "face.h"
 #include "vertex.h"
 #include "object.h"
 
+/* a guess at the number of indices per face, to size the index buffer */
+#define INDICES_PER_FACE 4
+
+
 /* init_object():
-   description: initalises an object. allocates space for the vertex array and
-                face array.
+   description: initalises an object. creates the arena for the object and
+                allocates space for the vertex array, face array and index
+                buffer from it.
    inputs: a pointer to an alloced object, the number of vertices it will take
            and the number of faces for the object
    outputs: true/false depending if the allocs were successful
@@ -30,16 +38,36 @@ bool init_object(object *o, int n_vert,int n_faces) {
   o->filled_vertices = 0;
   o->filled_faces = 0;
 
-  o->vertices = alloc_vertex_array(n_vert);
+  o->map = NULL;
+  o->map_size = 0;
+
+  o->lods = NULL;
+  o->n_lods = 0;
+  o->qvertices = NULL;
+  o->colours = NULL;
+
+  /* make the arena big enough for everything up front if we can */
+  o->mem = create_arena(sizeof(vertex) * (size_t) n_vert +
+                        sizeof(face) * (size_t) n_faces +
+                        sizeof(int) * (size_t) n_faces * INDICES_PER_FACE);
+  if(o->mem == NULL)
+    return false;
+
+  o->vertices = alloc_vertex_array(o->mem,n_vert);
 
   if(o->vertices == NULL)
     return false;
 
-  o->faces = alloc_face_array(n_faces);
+  o->faces = alloc_face_array(o->mem,n_faces);
   if(o->faces == NULL)
     return false;
 
-  return true;
+  /* the index buffer grows as faces are added */
+  o->indices = NULL;
+  o->n_indices = 0;
+  o->index_capacity = 0;
+
+  return reserve_indices(o,n_faces * INDICES_PER_FACE);
 }
 
 
@@ -49,19 +77,15 @@ bool init_object(object *o, int n_vert,int n_faces) {
    inputs: a pointer to the object to free the memory from
  */
 void free_object(object *o) {
-  int i;
-
   if(o == NULL) return;
 
-  /* free up the vertices */
-  free(o->vertices);
+  /* free up the vertices, faces and their indices all in one go */
+  free_arena(o->mem);
+  o->mem = NULL;
 
-  /* free up all the arrays of vertex indices for each face*/
-  for(i=0;i<o->filled_faces;i++)
-    free_face(o->faces+i);
-
-  /* free up all the faces*/
-  free(o->faces);
+  /* and the cache file they might have been in */
+  if(o->map != NULL)
+    munmap(o->map,o->map_size);
 }
 
 
@@ -119,58 +143,187 @@ void add_face(object *o,face f){
 }
 
 
+/* reserve_indices():
+   description: makes sure there's room for more indices in the object's
+                index buffer, doubling it if there isn't
+   inputs: a pointer to an alloced object, the number of extra indices
+   outputs: true/false depending if the (re)alloc was successful
+ */
+bool reserve_indices(object *o,int n){
+  int *new_indices;
+  int capacity;
+
+  if(o == NULL) return false;
+  if(o->n_indices + n <= o->index_capacity) return true;
+
+  capacity = o->index_capacity * 2;
+  if(capacity < o->n_indices + n)
+    capacity = o->n_indices + n;
+
+  new_indices = (int *) arena_realloc(o->mem,o->indices,
+                                      sizeof(int) * o->index_capacity,
+                                      sizeof(int) * capacity);
+  if(new_indices == NULL)
+    return false;
+
+  o->indices = new_indices;
+  o->index_capacity = capacity;
+
+  return true;
+}
+
+
+/* add_indices():
+   description: makes room for a face's vertex indices at the end of the
+                object's index buffer. The pointer is only good until the next
+                call, as the buffer may move.
+   inputs: a pointer to an alloced object, the face the indices are for
+   outputs: pointer to where the indices go or NULL
+ */
+int *add_indices(object *o,face *f){
+  if(o == NULL || f == NULL) return NULL;
+
+  if(reserve_indices(o,f->n_vertices) == false)
+    return NULL;
+
+  f->first_index = o->n_indices;
+  o->n_indices += f->n_vertices;
+
+  return o->indices + f->first_index;
+}
+
+
+/* material_hash():
+   description: hashes the draw mode and colour of a face, for grouping faces
+                that can be drawn together
+   inputs: the face to hash
+   output: the hash
+ */
+static unsigned int material_hash(face *f){
+  unsigned int h = 2166136261u, bits;
+  float c;
+  int i;
+
+  h = (h ^ f->draw_mode) * 16777619u;
+
+  for(i = 0; i < 3; i++){
+    /* adding zero turns -0 into 0, they're the same colour */
+    c = f->colour[i] + 0.0f;
+    memcpy(&bits,&c,sizeof(bits));
+    h = (h ^ bits) * 16777619u;
+  }
+
+  return h ^ (h >> 15);
+}
+
+
+/* same_material():
+   description: true if two faces can be drawn in one go. faces drawn as
+                GL_POLYGON never can
+ */
+static bool same_material(face *a, face *b){
+  return (a->draw_mode != GL_POLYGON) &&
+         (a->draw_mode == b->draw_mode) &&
+         (a->colour[0] == b->colour[0]) &&
+         (a->colour[1] == b->colour[1]) &&
+         (a->colour[2] == b->colour[2]) ? true : false;
+}
+
+
 /* optimise():
    description: "optimises" the object. It places all the indices for each face
      into a common face if they have the same colour and vertices (except for
      a face with more than 4 sides).
-     This is supposed to save calls to glDrawElement(). It will only work
-     with the 'vertex array' render mode with the INDEX_OPTIMISATION
-     preprocessor define set.
-     Unfortunately this function takes quite a while to run on complex models,
-     with no benifit seen.
+     This saves calls to glDrawElements() in the 'vertex array' render mode
+     (and glBegin()/glEnd() pairs in the others), down to one per material.
+     Faces are grouped in a single pass with a hash table keyed on the draw
+     mode and colour, then their indices are copied into place.
 
    inputs: an alloced object that has been filled with all the data
+   outputs: the number of faces the object was merged down to
  */
-void optimise(object *o){
-  face *old_faces = NULL;
-  face *new_faces = NULL;
-
+int optimise(object *o){
+  face *old_faces, *new_faces, *f;
+  int *batch = NULL, *table = NULL, *new_indices, *fill;
+  unsigned int size, slot;
   int i,j,n_faces = 0;
 
+  if(o == NULL || o->n_faces == 0) return 0;
+
   old_faces = o->faces;
 
-  /* Optimise everyface */
-  for(i=0;i < o->n_faces; i++){
-
-    /* Okay, now figure out whether or not we have a face with the same
-       draw_mode (not incl GL_POLYGON) and colour */
-    for(j=0;j<n_faces;j++){
-      if((old_faces[i].draw_mode != GL_POLYGON) &&
-         (new_faces[i].draw_mode == old_faces[i].draw_mode) &&
-         (new_faces[i].colour[0] == old_faces[i].colour[0]) &&
-         (new_faces[i].colour[1] == old_faces[i].colour[1]) &&
-         (new_faces[i].colour[2] == old_faces[i].colour[2]))
-        break;
+  /* a power of two, at least twice as big as the number of faces */
+  for(size = 2; size < 2 * (unsigned int) o->n_faces; size *= 2);
+
+  new_faces = alloc_face_array(o->mem,o->n_faces);
+  new_indices = (int *) arena_alloc(o->mem,sizeof(int) * o->n_indices);
+  batch = (int *) malloc(sizeof(int) * o->n_faces);
+  table = (int *) malloc(sizeof(int) * size);
+
+  if(new_faces == NULL || new_indices == NULL ||
+     batch == NULL || table == NULL) {
+    n_faces = o->n_faces;
+    goto out;
+  }
+
+  for(slot = 0; slot < size; slot++)
+    table[slot] = -1;
+
+  /* Work out which batch every face goes in */
+  for(i = 0; i < o->n_faces; i++){
+    f = old_faces + i;
+    j = -1;
+
+    if(f->draw_mode != GL_POLYGON) {
+      /* look for a batch with the same draw_mode and colour */
+      for(slot = material_hash(f) & (size - 1); table[slot] != -1;
+          slot = (slot + 1) & (size - 1))
+        if(same_material(new_faces + table[slot],f)) {
+          j = table[slot];
+          break;
+        }
     }
 
-    /* boohoo, nothing similar to this face so copy it to the new face list */
-    if(n_faces == j) {
-      /* copy the face across */
-      new_faces = add_face_to_array(new_faces,old_faces[i],&n_faces);
-    } else {
-    /* yippee, found a similar face, add my indices to the list! */
-      /* copy the indices to the array */
-      join_faces(&(new_faces[j]),old_faces[i]);
-
-      /* now weve copied the indicies, free up the old memory */
-      free_face(&(old_faces[i]));
+    /* boohoo, nothing similar to this face so start a new batch */
+    if(j == -1) {
+      j = n_faces++;
+      new_faces[j] = *f;
+      new_faces[j].n_vertices = 0;
+
+      if(f->draw_mode != GL_POLYGON)
+        table[slot] = j;
     }
 
+    new_faces[j].n_vertices += f->n_vertices;
+    batch[i] = j;
+  }
+
+  /* lay the batches out one after the other in the index buffer, then
+     use the table to keep track of how much of each we've filled */
+  fill = table;
+  for(j = 0, i = 0; j < n_faces; j++){
+    new_faces[j].first_index = fill[j] = i;
+    i += new_faces[j].n_vertices;
+  }
+
+  /* yippee, copy the indices across */
+  for(i = 0; i < o->n_faces; i++){
+    j = batch[i];
+    memcpy(new_indices + fill[j],FACE_INDICES(o,old_faces + i),
+           sizeof(int) * old_faces[i].n_vertices);
+    fill[j] += old_faces[i].n_vertices;
   }
 
-  /* Get rid of the old, unoptimised list and replace with the new */
-  free(old_faces);
+  /* Replace the old, unoptimised list with the new. The old one stays in
+     the arena until the object is freed */
   o->faces = new_faces;
-  o->n_faces = n_faces;
-}
+  o->n_faces = o->filled_faces = n_faces;
+  o->indices = new_indices;
+  o->index_capacity = o->n_indices;
+
+out:
+  free(batch);
+  free(table);
 
+  return n_faces;
+}
@@ -11,9 +11,21 @@
 #ifndef _CB_OBJECT_H
 #define _CB_OBJECT_H
 
+#include <stddef.h> /*for size_t*/
+
+#include "arena.h"
 #include "face.h"
 #include "vertex.h"
 
+/* a simpler version of an object. it has its own faces and index buffer,
+   but uses the object's vertices */
+typedef struct lod_t {
+  face *faces;
+  int n_faces;
+  int *indices;
+  int n_indices;
+} lod;
+
 typedef struct object_t {
   /* total number of vertices for this object */
   int n_vertices;
@@ -29,13 +41,47 @@ typedef struct object_t {
   vertex *vertices;
   face *faces;
 
+  /* every face's vertex indices, one after the other */
+  int *indices;
+  int n_indices;
+  int index_capacity;
+
+  /* everything belonging to the object is allocated from here, and freed
+     in one go */
+  arena *mem;
+
+  /* simpler versions of the object, each with fewer triangles than the
+     last. there aren't any unless they've been built */
+  lod *lods;
+  int n_lods;
+
+  /* a red, green, blue and alpha byte for each vertex, once the face
+     colours have been baked into the vertices */
+  unsigned char *colours;
+
+  /* the vertices squashed down for drawing, if they have been, and how to
+     scale and move them back to where they were */
+  qvertex *qvertices;
+  float q_offset[3];
+  float q_scale;
+
+  /* when loaded from the geometry cache, the vertices and indices live in
+     this mapping of the cache file rather than in the arena */
+  void *map;
+  size_t map_size;
+
 } object;
 
+/* the vertex indices of face f in object o */
+#define FACE_INDICES(o,f) ((o)->indices + (f)->first_index)
+
 /* interface function prototypes */
 bool init_object(object *,int,int);
 void free_object(object *);
 void add_vertex_p(object *,float,float,float,float,float,float);
 void add_vertex(object *,vertex);
 void add_face(object *,face);
-void optimise(object *);
+bool reserve_indices(object *,int);
+int *add_indices(object *,face *);
+int optimise(object *);
 #endif /* !_CB_OBJECT_H */
@@ -9,6 +9,8 @@
 #ifdef _WIN32 /* Unsupported! */
 #include <windows.h>
 #endif
+/* buffer objects and the like are only declared with this */
+#define GL_GLEXT_PROTOTYPES
 #include <GL/gl.h>
 #include <GL/glu.h>
 #include <GL/glut.h>
@@ -0,0 +1,175 @@
+/********************
+ * FILE: pool.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     A simple pool of worker threads. A batch of numbered jobs is handed to
+ *     the pool and everyone (including the caller) grabs jobs until the
+ *     batch is finished.
+ */
+
+#include <stdlib.h> /*for malloc*/
+#include <unistd.h> /*for sysconf*/
+
+#include "common.h"
+#include "pool.h"
+
+
+/* grab_jobs():
+   description: runs jobs from the current batch until there are none left.
+                must be called with the lock held, returns with it held.
+ */
+static void grab_jobs(pool *p){
+  int job;
+
+  while(p->next_job < p->n_jobs){
+    job = p->next_job++;
+
+    pthread_mutex_unlock(&p->lock);
+    p->job(p->data,job);
+    pthread_mutex_lock(&p->lock);
+
+    /* the last one out lets run_pool() know */
+    if(++p->done_jobs == p->n_jobs)
+      pthread_cond_broadcast(&p->finish);
+  }
+}
+
+
+/* worker():
+   description: the main loop of each worker thread. sleeps until there is
+                a new batch to work on
+ */
+static void *worker(void *arg){
+  pool *p = (pool *) arg;
+  int batch = 0;
+
+  pthread_mutex_lock(&p->lock);
+  while(true){
+    while(p->batch == batch && p->quit == false)
+      pthread_cond_wait(&p->start,&p->lock);
+
+    if(p->quit == true) break;
+
+    batch = p->batch;
+    grab_jobs(p);
+  }
+  pthread_mutex_unlock(&p->lock);
+
+  return NULL;
+}
+
+
+/* create_pool():
+   description: creates a pool and starts up its worker threads
+   inputs: the number of threads to use, including the calling thread
+   output: pointer to the new pool or NULL
+ */
+pool *create_pool(int n_threads){
+  pool *p;
+  int i;
+
+  if(n_threads < 1) n_threads = 1;
+
+  p = (pool *) malloc(sizeof(pool));
+  if(p == NULL) return NULL;
+
+  p->n_threads = n_threads;
+  p->n_jobs = p->next_job = p->done_jobs = 0;
+  p->batch = 0;
+  p->quit = false;
+
+  pthread_mutex_init(&p->lock,NULL);
+  pthread_cond_init(&p->start,NULL);
+  pthread_cond_init(&p->finish,NULL);
+
+  p->threads = (pthread_t *) malloc(sizeof(pthread_t) * n_threads);
+  if(p->threads == NULL) {
+    free(p);
+    return NULL;
+  }
+
+  /* the caller counts as the first thread */
+  for(i = 1; i < n_threads; i++)
+    if(pthread_create(&p->threads[i],NULL,worker,p) != 0)
+      break;
+
+  p->n_threads = i;
+
+  return p;
+}
+
+
+/* run_pool():
+   description: runs a batch of jobs across the pool and waits for them all
+                to finish. With a single thread the jobs are just run in turn
+   inputs: the pool, the number of jobs, the job function and its data
+ */
+void run_pool(pool *p,int n_jobs,pool_job job,void *data){
+  int i;
+
+  if(n_jobs <= 0) return;
+
+  if(p == NULL || p->n_threads == 1 || n_jobs == 1) {
+    for(i = 0; i < n_jobs; i++)
+      job(data,i);
+    return;
+  }
+
+  pthread_mutex_lock(&p->lock);
+  p->job = job;
+  p->data = data;
+  p->n_jobs = n_jobs;
+  p->next_job = 0;
+  p->done_jobs = 0;
+  p->batch++;
+  pthread_cond_broadcast(&p->start);
+
+  /* lend a hand, then wait for the stragglers */
+  grab_jobs(p);
+  while(p->done_jobs < p->n_jobs)
+    pthread_cond_wait(&p->finish,&p->lock);
+
+  p->n_jobs = 0;
+  pthread_mutex_unlock(&p->lock);
+}
+
+
+/* free_pool():
+   description: stops all the worker threads and frees the pool
+   inputs: the pool to free
+ */
+void free_pool(pool *p){
+  int i;
+
+  if(p == NULL) return;
+
+  pthread_mutex_lock(&p->lock);
+  p->quit = true;
+  pthread_cond_broadcast(&p->start);
+  pthread_mutex_unlock(&p->lock);
+
+  for(i = 1; i < p->n_threads; i++)
+    pthread_join(p->threads[i],NULL);
+
+  pthread_mutex_destroy(&p->lock);
+  pthread_cond_destroy(&p->start);
+  pthread_cond_destroy(&p->finish);
+
+  free(p->threads);
+  free(p);
+}
+
+
+/* default_threads():
+   description: works out how many threads to use if we aren't told
+   output: the number of online processors, at least 1
+ */
+int default_threads(void){
+  long n;
+
+  n = sysconf(_SC_NPROCESSORS_ONLN);
+
+  return n < 1 ? 1 : (int) n;
+}
@@ -0,0 +1,48 @@
+/********************
+ * FILE: pool.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for pool.c. Defines the worker pool structure and contains
+ *     the prototypes for the interface functions
+ */
+
+#ifndef _CB_POOL_H
+#define _CB_POOL_H
+
+#include <pthread.h>
+
+#include "common.h"
+
+/* a job to run on the pool. gets the shared data and the job number */
+typedef void (*pool_job)(void *, int);
+
+/* pool struct. a fixed set of worker threads that sit waiting for jobs */
+typedef struct pool_t {
+  /* the number of threads, including the one that calls run_pool() */
+  int n_threads;
+  pthread_t *threads;
+
+  pthread_mutex_t lock;
+  pthread_cond_t start;
+  pthread_cond_t finish;
+
+  /* the current batch of jobs */
+  pool_job job;
+  void *data;
+  int n_jobs;
+  int next_job;
+  int done_jobs;
+
+  /* bumped every batch so sleeping workers know there's something new */
+  int batch;
+  bool quit;
+} pool;
+
+/* interface function prototypes */
+pool *create_pool(int);
+void run_pool(pool *,int,pool_job,void *);
+void free_pool(pool *);
+int default_threads(void);
+#endif /* !_CB_POOL_H */
@@ -0,0 +1,110 @@
+/********************
+ * FILE: quantise.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Functions for squashing the vertices of an object into half the
+ *     space for drawing. Positions become 16 bit fractions of the model's
+ *     bounding box and normals 8 bit fractions of 1. The positions are
+ *     scaled back by the modelview matrix, and GL does the normals itself.
+ *     The float vertices are kept, for everything that works on the model
+ *     rather than drawing it.
+ */
+
+#include <math.h> /*for lrintf, sqrtf*/
+
+#include "common.h"
+#include "arena.h"
+#include "vertex.h"
+#include "object.h"
+#include "quantise.h"
+
+/* the biggest values a short and a signed char are given */
+#define POSITION_RANGE 32767
+#define NORMAL_RANGE 127
+
+
+/* quantise():
+   description: squashes a value between -1 and 1 into an integer between
+                -range and range
+ */
+static int quantise(float v, int range){
+  long q = lrintf(v * range);
+
+  if(q > range) return range;
+  if(q < -range) return -range;
+  return (int) q;
+}
+
+
+/* quantise_vertices():
+   description: makes the object's squashed vertices. they're centred on
+     the middle of the bounding box, and scaled the same in every direction
+     so the normals still work
+   inputs: an alloced object that has been filled with all the data, where
+           to put what it did
+   output: false if there wasn't enough memory
+ */
+bool quantise_vertices(object *o, quantise_stats *stats){
+  float min[3], max[3], p[3], d[3], scale, error;
+  vertex *v;
+  qvertex *q;
+  int i, j;
+
+  stats->bytes_before = (long) sizeof(vertex) * o->n_vertices;
+  stats->bytes_after = stats->bytes_before;
+  stats->error = 0;
+
+  if(o->n_vertices == 0) return true;
+
+  for(j = 0; j < 3; j++)
+    min[j] = max[j] = 0;
+
+  for(i = 0; i < o->n_vertices; i++){
+    v = o->vertices + i;
+    p[0] = v->x; p[1] = v->y; p[2] = v->z;
+    for(j = 0; j < 3; j++){
+      if(i == 0 || p[j] < min[j]) min[j] = p[j];
+      if(i == 0 || p[j] > max[j]) max[j] = p[j];
+    }
+  }
+
+  scale = 0;
+  for(j = 0; j < 3; j++){
+    o->q_offset[j] = (min[j] + max[j]) * 0.5f;
+    if((max[j] - min[j]) * 0.5f > scale)
+      scale = (max[j] - min[j]) * 0.5f;
+  }
+  if(scale == 0) scale = 1;
+  o->q_scale = scale / POSITION_RANGE;
+
+  o->qvertices = (qvertex *) arena_alloc(o->mem,
+                                         sizeof(qvertex) * o->n_vertices);
+  if(o->qvertices == NULL) return false;
+
+  for(i = 0; i < o->n_vertices; i++){
+    v = o->vertices + i;
+    q = o->qvertices + i;
+
+    q->x = quantise((v->x - o->q_offset[0]) / scale,POSITION_RANGE);
+    q->y = quantise((v->y - o->q_offset[1]) / scale,POSITION_RANGE);
+    q->z = quantise((v->z - o->q_offset[2]) / scale,POSITION_RANGE);
+    q->pad = 0;
+
+    q->normX = quantise(v->normX,NORMAL_RANGE);
+    q->normY = quantise(v->normY,NORMAL_RANGE);
+    q->normZ = quantise(v->normZ,NORMAL_RANGE);
+    q->pad2 = 0;
+
+    d[0] = q->x * o->q_scale + o->q_offset[0] - v->x;
+    d[1] = q->y * o->q_scale + o->q_offset[1] - v->y;
+    d[2] = q->z * o->q_scale + o->q_offset[2] - v->z;
+    error = sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+    if(error > stats->error)
+      stats->error = error;
+  }
+
+  stats->bytes_after = (long) sizeof(qvertex) * o->n_vertices;
+  return true;
+}
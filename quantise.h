@@ -0,0 +1,28 @@
+/********************
+ * FILE: quantise.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for quantise.c. Contains the prototypes for the interface
+ *     functions
+ */
+
+#ifndef _CB_QUANTISE_H
+#define _CB_QUANTISE_H
+
+#include "common.h"
+#include "object.h"
+
+/* what quantise_vertices() did, for printing */
+typedef struct {
+  long bytes_before;
+  long bytes_after;
+
+  /* the furthest any vertex moved */
+  float error;
+} quantise_stats;
+
+/* interface function prototypes */
+bool quantise_vertices(object *,quantise_stats *);
+#endif /* !_CB_QUANTISE_H */
@@ -0,0 +1,654 @@
+/********************
+ * FILE: raster.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     A software rasteriser, for drawing the model on machines without a
+ *     real graphics card. Each frame the vertices are moved and lit on the
+ *     pool, then the triangles are set up (clipped against the near plane,
+ *     culled, and turned into edge and attribute planes) on the pool too.
+ *     They're sorted into screen tiles, and each tile is filled by a pool
+ *     job on its own, 4 pixels at a time with SSE2 where the cpu has it.
+ *     The lighting is the same as render() sets up for GL: diffuse only,
+ *     from one directional light, worked out per vertex (Gouraud shading).
+ */
+
+#include <stdio.h>
+#include <stdlib.h> /*for malloc*/
+#include <string.h> /*for memset*/
+#include <math.h> /*for floorf*/
+
+#include "common.h"
+#include "platform.h"
+#include "face.h"
+#include "vertex.h"
+#include "object.h"
+#include "pool.h"
+#include "raster.h"
+
+#if defined(__GNUC__) && defined(__SSE2__)
+#define RASTER_SSE2
+#include <emmintrin.h>
+#endif
+
+/* the number of vertices and triangles each pool job works on */
+#define VERTICES_PER_JOB 4096
+#define TRIANGLES_PER_JOB 4096
+
+/* the light render() sets up, which the eye sees from the same angle
+   however far away it is */
+#define LIGHT_X 5.0f
+#define LIGHT_Y 5.0f
+#define LIGHT_Z 5.0f
+
+/* where each plane is in a raster_triangle */
+#define PLANE_Z 3
+#define PLANE_Q 4
+#define PLANE_COLOUR 5
+
+/* a corner of a triangle being clipped and set up */
+typedef struct {
+  float clip[4];
+  float colour[3];
+} corner;
+
+
+/* add_triangle():
+   description: adds a triangle to a mesh, unless its indices aren't real
+                vertices
+   inputs: the object, the mesh, the three indices and the face it's from
+ */
+static void add_triangle(object *o, raster_mesh *m, int a, int b, int c,
+                         face *f){
+  int *v = m->vertices + 3 * m->n_triangles;
+
+  if(a < 0 || a >= o->n_vertices || b < 0 || b >= o->n_vertices ||
+     c < 0 || c >= o->n_vertices)
+    return;
+
+  v[0] = a;
+  v[1] = b;
+  v[2] = c;
+  memcpy(m->colours + 3 * m->n_triangles,f->colour,sizeof(float) * 3);
+  m->n_triangles++;
+}
+
+
+/* build_mesh():
+   description: splits the faces into triangles, the same ones GL would
+                draw for each draw mode. strips swap every other triangle
+                around so they all wind the same way
+   inputs: the object, the faces and indices to use, the mesh to fill
+   output: false if there wasn't enough memory
+ */
+static bool build_mesh(object *o, face *faces, int n_faces, int *indices,
+                       raster_mesh *m){
+  int i, j, n = 0, *v;
+  face *f;
+
+  for(i = 0; i < n_faces; i++)
+    if(faces[i].n_vertices >= 3)
+      n += faces[i].n_vertices - 2;
+
+  m->n_triangles = 0;
+  m->vertices = (int *) malloc(sizeof(int) * 3 * n + 1);
+  m->colours = (float *) malloc(sizeof(float) * 3 * n + 1);
+  if(m->vertices == NULL || m->colours == NULL) return false;
+
+  for(i = 0; i < n_faces; i++){
+    f = faces + i;
+    v = indices + f->first_index;
+
+    if(f->draw_mode == GL_TRIANGLES)
+      for(j = 0; j + 2 < f->n_vertices; j += 3)
+        add_triangle(o,m,v[j],v[j + 1],v[j + 2],f);
+    else if(f->draw_mode == GL_TRIANGLE_STRIP)
+      for(j = 0; j + 2 < f->n_vertices; j++){
+        if(j % 2 == 0)
+          add_triangle(o,m,v[j],v[j + 1],v[j + 2],f);
+        else
+          add_triangle(o,m,v[j + 1],v[j],v[j + 2],f);
+      }
+    else if(f->draw_mode == GL_QUADS)
+      for(j = 0; j + 3 < f->n_vertices; j += 4){
+        add_triangle(o,m,v[j],v[j + 1],v[j + 3],f);
+        add_triangle(o,m,v[j + 1],v[j + 2],v[j + 3],f);
+      }
+    else if(f->draw_mode == GL_POLYGON || f->draw_mode == GL_TRIANGLE_FAN)
+      for(j = 1; j + 1 < f->n_vertices; j++)
+        add_triangle(o,m,v[0],v[j],v[j + 1],f);
+  }
+
+  return true;
+}
+
+
+/* create_raster():
+   description: makes a rasteriser for the object, and its levels of
+                detail. it has no buffers to draw into until
+                resize_raster() is called
+   inputs: an alloced object that has been filled with all the data, the
+           pool to do the work on
+   output: the rasteriser, or NULL if there wasn't enough memory
+ */
+raster *create_raster(object *o, pool *workers){
+  raster *rs;
+  face *faces;
+  int i, n_faces, *indices, largest = 0;
+
+  if(o == NULL || workers == NULL) return NULL;
+
+  if((rs = (raster *) malloc(sizeof(raster))) == NULL) return NULL;
+  memset(rs,0,sizeof(raster));
+
+  rs->obj = o;
+  rs->workers = workers;
+  rs->n_meshes = o->n_lods + 1;
+  rs->meshes = (raster_mesh *) calloc(rs->n_meshes,sizeof(raster_mesh));
+  rs->vertices = (raster_vertex *) malloc(sizeof(raster_vertex) *
+                                          o->n_vertices + 1);
+  if(rs->meshes == NULL || rs->vertices == NULL) return NULL;
+
+  /* the model, then each level of detail */
+  for(i = 0; i < rs->n_meshes; i++){
+    if(i == 0) {
+      faces = o->faces;
+      n_faces = o->n_faces;
+      indices = o->indices;
+    } else {
+      faces = o->lods[i - 1].faces;
+      n_faces = o->lods[i - 1].n_faces;
+      indices = o->lods[i - 1].indices;
+    }
+
+    if(build_mesh(o,faces,n_faces,indices,rs->meshes + i) == false)
+      return NULL;
+    if(rs->meshes[i].n_triangles > largest)
+      largest = rs->meshes[i].n_triangles;
+  }
+
+  /* clipping against the near plane can split a triangle in two */
+  rs->tris_size = 2 * largest;
+  rs->tris = (raster_triangle *) malloc(sizeof(raster_triangle) *
+                                        rs->tris_size + 1);
+  if(rs->tris == NULL) return NULL;
+
+  return rs;
+}
+
+
+/* resize_raster():
+   description: makes the colour and depth buffers, and the tile bins, fit
+                a new window size
+   inputs: the rasteriser, the width and height
+   output: false if there wasn't enough memory
+ */
+bool resize_raster(raster *rs, int w, int h){
+  int i, n_tiles;
+
+  if(rs == NULL || w < 0 || h < 0) return false;
+
+  for(i = 0; i < rs->tiles_x * rs->tiles_y; i++)
+    free(rs->bins[i]);
+  free(rs->bins);
+  free(rs->bin_counts);
+  free(rs->bin_sizes);
+  free(rs->colour);
+  free(rs->depth);
+
+  /* rows are padded to whole groups of 4 pixels */
+  rs->width = w;
+  rs->height = h;
+  rs->stride = (w + 3) & ~3;
+  rs->tiles_x = (w + RASTER_TILE - 1) / RASTER_TILE;
+  rs->tiles_y = (h + RASTER_TILE - 1) / RASTER_TILE;
+  n_tiles = rs->tiles_x * rs->tiles_y;
+
+  rs->colour = (unsigned char *) malloc(4 * (size_t) rs->stride * h + 1);
+  rs->depth = (float *) malloc(sizeof(float) * (size_t) rs->stride * h + 1);
+  rs->bins = (int **) calloc(n_tiles + 1,sizeof(int *));
+  rs->bin_counts = (int *) calloc(n_tiles + 1,sizeof(int));
+  rs->bin_sizes = (int *) calloc(n_tiles + 1,sizeof(int));
+
+  if(rs->colour == NULL || rs->depth == NULL || rs->bins == NULL ||
+     rs->bin_counts == NULL || rs->bin_sizes == NULL) {
+    rs->tiles_x = rs->tiles_y = 0;
+    return false;
+  }
+
+  return true;
+}
+
+
+/* vertices_job():
+   description: a pool job moving some of the vertices into clip space and
+                working out how much light each one gets. like GL without
+                GL_NORMALIZE, the normals aren't made unit length
+ */
+static void vertices_job(void *data, int job){
+  raster *rs = (raster *) data;
+  object *o = rs->obj;
+  float *m = rs->matrix, *nm = rs->normal_matrix, n[3], d;
+  int i, end = (job + 1) * VERTICES_PER_JOB;
+  raster_vertex *out;
+  vertex *v;
+
+  if(end > o->n_vertices)
+    end = o->n_vertices;
+
+  for(i = job * VERTICES_PER_JOB; i < end; i++){
+    v = o->vertices + i;
+    out = rs->vertices + i;
+
+    out->clip[0] = m[0] * v->x + m[4] * v->y + m[8] * v->z + m[12];
+    out->clip[1] = m[1] * v->x + m[5] * v->y + m[9] * v->z + m[13];
+    out->clip[2] = m[2] * v->x + m[6] * v->y + m[10] * v->z + m[14];
+    out->clip[3] = m[3] * v->x + m[7] * v->y + m[11] * v->z + m[15];
+
+    n[0] = nm[0] * v->normX + nm[3] * v->normY + nm[6] * v->normZ;
+    n[1] = nm[1] * v->normX + nm[4] * v->normY + nm[7] * v->normZ;
+    n[2] = nm[2] * v->normX + nm[5] * v->normY + nm[8] * v->normZ;
+
+    d = n[0] * rs->light[0] + n[1] * rs->light[1] + n[2] * rs->light[2];
+    out->light = d > 0.0f ? d : 0.0f;
+  }
+}
+
+
+/* clip_near():
+   description: cuts a triangle against the near plane (where z = -w)
+   inputs: the triangle's corners, where to put the corners left
+   output: how many corners are left, 0, 3 or 4
+ */
+static int clip_near(corner *in, corner *out){
+  int i, j, k, n = 0;
+  float di, dj, t;
+
+  for(i = 0; i < 3; i++){
+    j = (i + 1) % 3;
+    di = in[i].clip[2] + in[i].clip[3];
+    dj = in[j].clip[2] + in[j].clip[3];
+
+    if(di >= 0.0f)
+      out[n++] = in[i];
+
+    /* the edge crosses the plane */
+    if((di >= 0.0f) != (dj >= 0.0f)) {
+      t = di / (di - dj);
+      for(k = 0; k < 4; k++)
+        out[n].clip[k] = in[i].clip[k] + t * (in[j].clip[k] - in[i].clip[k]);
+      for(k = 0; k < 3; k++)
+        out[n].colour[k] = in[i].colour[k] +
+                           t * (in[j].colour[k] - in[i].colour[k]);
+      n++;
+    }
+  }
+
+  return n;
+}
+
+
+/* setup_triangle():
+   description: turns a triangle in clip space into pixel space planes. the
+                edge planes are divided by the area, so they're the
+                barycentric weights of the corners, and the other planes
+                are made from them. everything is worked out from the
+                corner of the triangle's box to keep the floats accurate
+   inputs: the rasteriser, the corners, the triangle to fill in
+   output: false if there's nothing to draw (no area, facing away when
+           culling, or missing the screen)
+ */
+static bool setup_triangle(raster *rs, corner *c, raster_triangle *t){
+  float sx[3], sy[3], *s[2] = {sx, sy}, a[8][3], area, inv, lo, hi;
+  int limit[2] = {rs->width, rs->height};
+  int i, j, k;
+
+  for(i = 0; i < 3; i++){
+    inv = 1.0f / c[i].clip[3];
+    sx[i] = (c[i].clip[0] * inv * 0.5f + 0.5f) * rs->width;
+    sy[i] = (c[i].clip[1] * inv * 0.5f + 0.5f) * rs->height;
+    a[PLANE_Z][i] = c[i].clip[2] * inv;
+    a[PLANE_Q][i] = inv;
+    for(k = 0; k < 3; k++)
+      a[PLANE_COLOUR + k][i] = c[i].colour[k] * inv;
+  }
+
+  /* counter clockwise is the front, like GL */
+  area = (sx[1] - sx[0]) * (sy[2] - sy[0]) - (sx[2] - sx[0]) * (sy[1] - sy[0]);
+  if(area == 0.0f || (rs->culling == true && area < 0.0f)) return false;
+
+  /* the pixels whose centres are inside the box, on the screen */
+  for(k = 0; k < 2; k++){
+    lo = hi = s[k][0];
+    for(i = 1; i < 3; i++){
+      if(s[k][i] < lo) lo = s[k][i];
+      if(s[k][i] > hi) hi = s[k][i];
+    }
+    if(hi < 0.5f || lo > limit[k] - 0.5f) return false;
+
+    t->min[k] = lo < 0.0f ? 0 : (int) ceilf(lo - 0.5f);
+    t->max[k] = hi > limit[k] ? limit[k] - 1 : (int) floorf(hi - 0.5f);
+    if(t->min[k] > t->max[k]) return false;
+  }
+
+  for(i = 0; i < 3; i++){
+    sx[i] -= t->min[0];
+    sy[i] -= t->min[1];
+  }
+
+  inv = 1.0f / area;
+  for(i = 0; i < 3; i++){
+    j = (i + 1) % 3;
+    k = (i + 2) % 3;
+    t->planes[i][0] = (sy[j] - sy[k]) * inv;
+    t->planes[i][1] = (sx[k] - sx[j]) * inv;
+    t->planes[i][2] = (sx[j] * sy[k] - sx[k] * sy[j]) * inv;
+  }
+
+  for(k = PLANE_Z; k < 8; k++)
+    for(i = 0; i < 3; i++)
+      t->planes[k][i] = a[k][0] * t->planes[0][i] +
+                        a[k][1] * t->planes[1][i] +
+                        a[k][2] * t->planes[2][i];
+
+  return true;
+}
+
+
+/* outside():
+   description: true if every corner is outside the same side of the view
+ */
+static bool outside(corner *c){
+  int k;
+
+  for(k = 0; k < 3; k++){
+    if(c[0].clip[k] > c[0].clip[3] && c[1].clip[k] > c[1].clip[3] &&
+       c[2].clip[k] > c[2].clip[3])
+      return true;
+    if(c[0].clip[k] < -c[0].clip[3] && c[1].clip[k] < -c[1].clip[3] &&
+       c[2].clip[k] < -c[2].clip[3])
+      return true;
+  }
+
+  return false;
+}
+
+
+/* triangles_job():
+   description: a pool job setting up some of the mesh's triangles. each
+                one has two places in the triangle array, for if the near
+                plane cuts it into a quad
+ */
+static void triangles_job(void *data, int job){
+  raster *rs = (raster *) data;
+  raster_mesh *m = rs->mesh;
+  unsigned char *colours = (rs->obj)->colours;
+  raster_triangle *t;
+  raster_vertex *v;
+  corner c[3], clipped[4];
+  int i, j, k, n, end = (job + 1) * TRIANGLES_PER_JOB;
+  float *colour, lit;
+
+  if(end > m->n_triangles)
+    end = m->n_triangles;
+
+  for(i = job * TRIANGLES_PER_JOB; i < end; i++){
+    t = rs->tris + 2 * i;
+    t[0].visible = t[1].visible = false;
+
+    colour = m->colours + 3 * i;
+    for(j = 0; j < 3; j++){
+      v = rs->vertices + m->vertices[3 * i + j];
+      memcpy(c[j].clip,v->clip,sizeof(float) * 4);
+
+      /* the colour material tracks the face's colour, or the vertex's
+         when they've been baked in */
+      for(k = 0; k < 3; k++){
+        if(colours != NULL)
+          lit = colours[4 * m->vertices[3 * i + j] + k] / 255.0f * v->light;
+        else
+          lit = colour[k] * v->light;
+        c[j].colour[k] = lit > 1.0f ? 1.0f : lit;
+      }
+    }
+
+    if(outside(c) == true) continue;
+
+    if(c[0].clip[2] >= -c[0].clip[3] && c[1].clip[2] >= -c[1].clip[3] &&
+       c[2].clip[2] >= -c[2].clip[3]) {
+      t[0].visible = setup_triangle(rs,c,t);
+      continue;
+    }
+
+    n = clip_near(c,clipped);
+    if(n >= 3)
+      t[0].visible = setup_triangle(rs,clipped,t);
+    if(n == 4) {
+      clipped[1] = clipped[0];
+      t[1].visible = setup_triangle(rs,clipped + 1,t + 1);
+    }
+  }
+}
+
+
+/* bin_triangles():
+   description: puts every visible triangle into the list of each tile its
+                box touches, in the order they're drawn
+   output: the number of visible triangles
+ */
+static long bin_triangles(raster *rs){
+  raster_triangle *t;
+  int i, tx, ty, tile, n_tris = 2 * (rs->mesh)->n_triangles;
+  long drawn = 0;
+
+  memset(rs->bin_counts,0,sizeof(int) * rs->tiles_x * rs->tiles_y);
+
+  for(i = 0; i < n_tris; i++){
+    t = rs->tris + i;
+    if(t->visible == false) continue;
+    drawn++;
+
+    for(ty = t->min[1] / RASTER_TILE; ty <= t->max[1] / RASTER_TILE; ty++)
+      for(tx = t->min[0] / RASTER_TILE; tx <= t->max[0] / RASTER_TILE; tx++){
+        tile = ty * rs->tiles_x + tx;
+
+        if(rs->bin_counts[tile] == rs->bin_sizes[tile]) {
+          rs->bin_sizes[tile] = rs->bin_sizes[tile] * 2 + 64;
+          rs->bins[tile] = (int *) realloc(rs->bins[tile],sizeof(int) *
+                                           rs->bin_sizes[tile]);
+          if(rs->bins[tile] == NULL){
+            fprintf(stderr,"Error: unable to allocate memory for the "
+                    "tiles\n");
+            exit(1);
+          }
+        }
+
+        rs->bins[tile][rs->bin_counts[tile]++] = i;
+      }
+  }
+
+  return drawn;
+}
+
+
+#ifdef RASTER_SSE2
+
+/* fill_row():
+   description: fills the pixels of a triangle on one row of a tile, 4 at a
+                time. the pixels are in if they're inside all 3 edges and
+                nearer than what's already there. the colour is divided by
+                1/w to put the perspective back
+   inputs: the rasteriser, the triangle, the row, the first and last
+           pixels (the first a multiple of 4)
+ */
+static void fill_row(raster *rs, raster_triangle *t, int y, int x0, int x1){
+  float fy = y - t->min[1] + 0.5f;
+  unsigned int *colour = (unsigned int *) rs->colour + y * rs->stride;
+  float *depth = rs->depth + y * rs->stride;
+  __m128 xs, row[8], a[8], e0, e1, e2, zs, zbuf, q, c;
+  __m128 zero = _mm_setzero_ps(), one = _mm_set1_ps(1.0f);
+  __m128 scale = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+  __m128i mask, rgba, old;
+  int i, x;
+
+  for(i = 0; i < 8; i++){
+    a[i] = _mm_set1_ps(t->planes[i][0]);
+    row[i] = _mm_set1_ps(t->planes[i][1] * fy + t->planes[i][2]);
+  }
+
+  xs = _mm_add_ps(_mm_set1_ps(x0 - t->min[0] + 0.5f),
+                  _mm_set_ps(3.0f,2.0f,1.0f,0.0f));
+
+  for(x = x0; x <= x1; x += 4, xs = _mm_add_ps(xs,_mm_set1_ps(4.0f))){
+    e0 = _mm_add_ps(_mm_mul_ps(a[0],xs),row[0]);
+    e1 = _mm_add_ps(_mm_mul_ps(a[1],xs),row[1]);
+    e2 = _mm_add_ps(_mm_mul_ps(a[2],xs),row[2]);
+    e0 = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0,zero),_mm_cmpge_ps(e1,zero)),
+                    _mm_cmpge_ps(e2,zero));
+    if(_mm_movemask_ps(e0) == 0) continue;
+
+    zs = _mm_add_ps(_mm_mul_ps(a[PLANE_Z],xs),row[PLANE_Z]);
+    zbuf = _mm_loadu_ps(depth + x);
+    e0 = _mm_and_ps(e0,_mm_cmplt_ps(zs,zbuf));
+    if(_mm_movemask_ps(e0) == 0) continue;
+
+    _mm_storeu_ps(depth + x,_mm_or_ps(_mm_and_ps(e0,zs),
+                                      _mm_andnot_ps(e0,zbuf)));
+
+    /* the colour, a byte a channel with alpha at 255 */
+    q = _mm_div_ps(one,_mm_add_ps(_mm_mul_ps(a[PLANE_Q],xs),row[PLANE_Q]));
+    rgba = _mm_set1_epi32((int) 0xff000000);
+    for(i = 0; i < 3; i++){
+      c = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(a[PLANE_COLOUR + i],xs),
+                                row[PLANE_COLOUR + i]),q);
+      c = _mm_min_ps(_mm_max_ps(c,zero),one);
+      c = _mm_add_ps(_mm_mul_ps(c,scale),half);
+      rgba = _mm_or_si128(rgba,_mm_slli_epi32(_mm_cvttps_epi32(c),8 * i));
+    }
+
+    mask = _mm_castps_si128(e0);
+    old = _mm_loadu_si128((__m128i *) (colour + x));
+    _mm_storeu_si128((__m128i *) (colour + x),
+                     _mm_or_si128(_mm_and_si128(mask,rgba),
+                                  _mm_andnot_si128(mask,old)));
+  }
+}
+
+#else
+
+/* fill_row():
+   description: fills the pixels of a triangle on one row of a tile, a
+                pixel at a time, for cpus without SSE2
+ */
+static void fill_row(raster *rs, raster_triangle *t, int y, int x0, int x1){
+  float fx, fy = y - t->min[1] + 0.5f, v[8], q;
+  unsigned char *colour = rs->colour + 4 * y * rs->stride;
+  float *depth = rs->depth + y * rs->stride;
+  int i, x;
+
+  for(x = x0; x <= x1; x++){
+    fx = x - t->min[0] + 0.5f;
+    for(i = 0; i < 8; i++)
+      v[i] = t->planes[i][0] * fx + t->planes[i][1] * fy + t->planes[i][2];
+
+    if(v[0] < 0.0f || v[1] < 0.0f || v[2] < 0.0f) continue;
+    if(v[PLANE_Z] >= depth[x]) continue;
+
+    depth[x] = v[PLANE_Z];
+    q = 1.0f / v[PLANE_Q];
+    for(i = 0; i < 3; i++){
+      v[PLANE_COLOUR + i] *= q;
+      if(v[PLANE_COLOUR + i] < 0.0f) v[PLANE_COLOUR + i] = 0.0f;
+      if(v[PLANE_COLOUR + i] > 1.0f) v[PLANE_COLOUR + i] = 1.0f;
+      colour[4 * x + i] = (unsigned char) (v[PLANE_COLOUR + i] * 255.0f + 0.5f);
+    }
+    colour[4 * x + 3] = 255;
+  }
+}
+
+#endif
+
+
+/* tile_job():
+   description: a pool job clearing one tile and filling in the triangles
+                binned into it, in order
+ */
+static void tile_job(void *data, int job){
+  raster *rs = (raster *) data;
+  int tx = job % rs->tiles_x, ty = job / rs->tiles_x;
+  int x0 = tx * RASTER_TILE, y0 = ty * RASTER_TILE;
+  int x1 = x0 + RASTER_TILE, y1 = y0 + RASTER_TILE;
+  int i, x, y, from, to;
+  raster_triangle *t;
+
+  /* the last column of tiles clears the padding on the end of the rows */
+  if(x1 > rs->width) x1 = rs->stride;
+  if(y1 > rs->height) y1 = rs->height;
+
+  for(y = y0; y < y1; y++){
+    memset(rs->colour + 4 * (y * rs->stride + x0),0,4 * (x1 - x0));
+    for(x = x0; x < x1; x++)
+      rs->depth[y * rs->stride + x] = 1.0f;
+  }
+
+  for(i = 0; i < rs->bin_counts[job]; i++){
+    t = rs->tris + rs->bins[job][i];
+
+    from = t->min[0] > x0 ? t->min[0] : x0;
+    to = t->max[0] < x1 - 1 ? t->max[0] : x1 - 1;
+#ifdef RASTER_SSE2
+    from &= ~3;
+#endif
+
+    for(y = t->min[1] > y0 ? t->min[1] : y0;
+        y <= t->max[1] && y < y1; y++)
+      fill_row(rs,t,y,from,to);
+  }
+}
+
+
+/* draw_raster():
+   description: draws a frame into the colour buffer
+   inputs: the rasteriser, the level of detail (-1 for the model), the
+           modelview and projection matrices, true to cull back faces
+   output: the number of triangles filled in
+ */
+long draw_raster(raster *rs, int level, float *modelview, float *projection,
+                 bool culling){
+  object *o;
+  float d;
+  int i, j, k;
+
+  if(rs == NULL || rs->tiles_x == 0) return 0;
+  o = rs->obj;
+
+  rs->mesh = rs->meshes + level + 1;
+  rs->culling = culling;
+
+  /* both matrices are stored a column at a time */
+  for(i = 0; i < 4; i++)
+    for(j = 0; j < 4; j++){
+      rs->matrix[i * 4 + j] = 0.0f;
+      for(k = 0; k < 4; k++)
+        rs->matrix[i * 4 + j] += projection[k * 4 + j] * modelview[i * 4 + k];
+    }
+
+  for(i = 0; i < 3; i++)
+    for(j = 0; j < 3; j++)
+      rs->normal_matrix[i * 3 + j] = modelview[i * 4 + j];
+
+  d = sqrtf(LIGHT_X * LIGHT_X + LIGHT_Y * LIGHT_Y + LIGHT_Z * LIGHT_Z);
+  rs->light[0] = LIGHT_X / d;
+  rs->light[1] = LIGHT_Y / d;
+  rs->light[2] = LIGHT_Z / d;
+
+  run_pool(rs->workers,(o->n_vertices + VERTICES_PER_JOB - 1) /
+           VERTICES_PER_JOB,vertices_job,rs);
+  run_pool(rs->workers,((rs->mesh)->n_triangles + TRIANGLES_PER_JOB - 1) /
+           TRIANGLES_PER_JOB,triangles_job,rs);
+  rs->drawn = bin_triangles(rs);
+  run_pool(rs->workers,rs->tiles_x * rs->tiles_y,tile_job,rs);
+
+  return rs->drawn;
+}
@@ -0,0 +1,84 @@
+/********************
+ * FILE: raster.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for raster.c. Defines the software rasteriser's
+ *     structures and contains the prototypes for the interface functions
+ */
+
+#ifndef _CB_RASTER_H
+#define _CB_RASTER_H
+
+#include "common.h"
+#include "object.h"
+#include "pool.h"
+
+/* the width and height of the screen tiles each pool job fills. a multiple
+   of 4, the pixels done at once */
+#define RASTER_TILE 64
+
+/* a vertex after it's been moved into clip space and lit */
+typedef struct {
+  float clip[4];
+  float light;
+} raster_vertex;
+
+/* the triangles of the model, or a level of detail, and their colours */
+typedef struct {
+  int *vertices;
+  float *colours;
+  int n_triangles;
+} raster_mesh;
+
+/* a triangle ready to fill. each plane gives a value at a pixel from
+   a * x + b * y + c. the first 3 are how far inside each edge the pixel
+   is, then the depth, 1/w and the colour over w. the box is in pixels */
+typedef struct {
+  float planes[8][3];
+  int min[2];
+  int max[2];
+  bool visible;
+} raster_triangle;
+
+/* raster struct. the meshes to draw, the colour and depth buffers (rows
+   stride pixels long, the bottom row first like glDrawPixels wants) and
+   the triangles binned into each tile for the frame being drawn */
+typedef struct raster_t {
+  object *obj;
+  pool *workers;
+
+  raster_mesh *meshes;
+  int n_meshes;
+
+  int width;
+  int height;
+  int stride;
+  unsigned char *colour;
+  float *depth;
+
+  raster_vertex *vertices;
+  raster_triangle *tris;
+  int tris_size;
+
+  int tiles_x;
+  int tiles_y;
+  int **bins;
+  int *bin_counts;
+  int *bin_sizes;
+
+  /* the frame being drawn */
+  raster_mesh *mesh;
+  float matrix[16];
+  float normal_matrix[9];
+  float light[3];
+  bool culling;
+  long drawn;
+} raster;
+
+/* interface function prototypes */
+raster *create_raster(object *,pool *);
+bool resize_raster(raster *,int,int);
+long draw_raster(raster *,int,float *,float *,bool);
+#endif /* !_CB_RASTER_H */
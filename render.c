@@ -9,7 +9,10 @@
  */
 
 #include <stdio.h>
+#include <stddef.h> /*for offsetof*/
 #include <stdlib.h> /*for malloc*/
+#include <string.h> /*for memset*/
+#include <math.h> /*for tan*/
 
 #include "common.h"
 #include "platform.h"
@@ -17,14 +20,221 @@
 #include "object.h"
 #include "face.h"
 #include "vertex.h"
-#include "trackball.h"
+#include "matrix.h"
 
 
 /* Function prototypes for non interface functions */
 void init_display_list(renderer *);
 void init_vertex_array(renderer *);
+void init_buffer_objects(renderer *);
+void init_multi_draw(renderer *);
+void init_shader(renderer *);
 void render_normal(renderer *);
 void render_vertex_array(renderer *);
+void render_clusters(renderer *);
+void render_hierarchy(renderer *);
+void render_multi_draw(renderer *);
+void render_shader(renderer *);
+void render_software(renderer *);
+
+/* where the eye sits (times the zoom) and how wide it sees */
+#define EYE_DISTANCE 5.0
+#define FIELD_OF_VIEW 60.0
+
+/* how close the eye can get, and how far away before the model goes past
+   the far clipping plane */
+#define MIN_ZOOM 0.3
+#define MAX_ZOOM 7.5
+
+/* a simpler level of detail is used when the model has more than one
+   triangle for this many pixels it covers */
+#define PIXELS_PER_TRIANGLE 2.0
+
+
+/* model_radius():
+   description: how far the furthest vertex is from the centre, which is
+                what the model turns around
+ */
+static float model_radius(object *o){
+  float d, radius = 0;
+  vertex *v;
+  int i;
+
+  for(i = 0; i < o->n_vertices; i++){
+    v = o->vertices + i;
+    d = v->x * v->x + v->y * v->y + v->z * v->z;
+    if(d > radius)
+      radius = d;
+  }
+
+  return sqrtf(radius);
+}
+
+
+/* choose_level():
+   description: picks the level of detail to draw. it's the simplest one
+                that still has a triangle for every PIXELS_PER_TRIANGLE
+                pixels the model covers on the screen, or the model itself
+                if none do. the area is worked out from the zoom and the
+                field of view
+ */
+static void choose_level(renderer *r){
+  object *o = r->obj;
+  double distance, size, budget;
+  int i;
+
+  r->level = -1;
+  if(o->n_lods == 0 || r->type == clustered || r->type == hierarchy) return;
+
+  distance = EYE_DISTANCE * r->zoom;
+  if(distance <= r->radius) return;
+
+  size = r->radius / (distance * tan(FIELD_OF_VIEW * M_PI / 360.0)) *
+         r->height / 2.0;
+  budget = M_PI * size * size / PIXELS_PER_TRIANGLE;
+
+  for(i = 0; i < o->n_lods; i++)
+    if(o->lods[i].n_indices / 3 >= budget)
+      r->level = i;
+}
+
+
+/* dequantise():
+   description: if the vertices being drawn are the squashed ones, scales
+                and moves them back to where the model's vertices are.
+                only the vertex array modes draw them
+   inputs: the renderer, the matrix to add it to
+ */
+static void dequantise(renderer *r, float *m){
+  object *o = r->obj;
+
+  if(o->qvertices == NULL || r->type == normal || r->type == display_list ||
+     r->type == software)
+    return;
+
+  mat_translate(m,o->q_offset[0],o->q_offset[1],o->q_offset[2]);
+  mat_scale(m,o->q_scale,o->q_scale,o->q_scale);
+}
+
+
+/* rotate_axis():
+   description: rotates a matrix around the x, y or z axis
+   inputs: the matrix, the angle in degrees, the axis
+ */
+static void rotate_axis(float *m, float angle, axis a){
+  if(a == x)
+    mat_rotate(m,angle,1,0,0);
+  else if(a == y)
+    mat_rotate(m,angle,0,1,0);
+  else if(a == z)
+    mat_rotate(m,angle,0,0,1);
+}
+
+
+/* setup_lighting():
+   description: sets up the light and the material, once. the light is
+                directional, so it's the same set under the identity as
+                under the eye's move back along z, and it stays put
+                relative to the eye whatever the model does
+ */
+static void setup_lighting(renderer *r){
+  float lightpos[] = {5.0f,5.0f,5.0f,0.0f};
+  float lightcolor[] = {1.0f, 1.0f, 1.0f, 1.0f};
+  float objectmat[] = {1.0f, 1.0f, 1.0f, 1.0f};
+  float zero[] = {0.0f, 0.0f, 0.0f, 1.0f};
+
+  glMatrixMode(GL_MODELVIEW);
+  glLoadIdentity();
+
+  /* Setup the lighting */
+  state_light_model(&r->state, GL_LIGHT_MODEL_AMBIENT, zero);
+  state_light(&r->state, GL_LIGHT0, GL_POSITION, lightpos);
+  state_light(&r->state, GL_LIGHT0, GL_DIFFUSE, lightcolor);
+  state_enable(&r->state, GL_LIGHT0, true);
+
+  /* Setup the colours on the object */
+  state_material(&r->state, GL_FRONT, GL_DIFFUSE, objectmat, 4);
+  state_material(&r->state, GL_FRONT, GL_SPECULAR, zero, 4);
+  state_material(&r->state, GL_FRONT, GL_SHININESS, zero, 1);
+}
+
+
+/* the address of index i in an index buffer of the renderer's type */
+#define INDEX_AT(r,base,i) \
+  ((void *) ((char *) (base) + (size_t) (i) * (r)->index_size))
+
+
+/* choose_index_type():
+   description: picks the smallest index type that can hold the number of
+                every vertex in the object
+ */
+static void choose_index_type(renderer *r){
+  if((r->obj)->n_vertices <= 256) {
+    r->index_type = GL_UNSIGNED_BYTE;
+    r->index_size = 1;
+  } else if((r->obj)->n_vertices <= 65536) {
+    r->index_type = GL_UNSIGNED_SHORT;
+    r->index_size = 2;
+  } else {
+    r->index_type = GL_UNSIGNED_INT;
+    r->index_size = 4;
+  }
+}
+
+
+/* narrow_indices():
+   description: copies an index buffer into the renderer's index type,
+                and counts how much smaller it is
+   inputs: the renderer, the indices and how many there are
+   output: the copy, or the indices themselves if they're already ints
+ */
+static void *narrow_indices(renderer *r, int *indices, int n){
+  unsigned short *shorts;
+  unsigned char *bytes;
+  int i;
+
+  r->index_bytes_before += (long) sizeof(int) * n;
+  r->index_bytes_after += (long) r->index_size * n;
+
+  if(r->index_type == GL_UNSIGNED_INT) return indices;
+
+  if((bytes = (unsigned char *) malloc(r->index_size * (size_t) n + 1)) == NULL){
+    fprintf(stderr,"Error: unable to allocate memory for the indices\n");
+    exit(1);
+  }
+
+  if(r->index_type == GL_UNSIGNED_SHORT) {
+    shorts = (unsigned short *) bytes;
+    for(i = 0; i < n; i++)
+      shorts[i] = (unsigned short) indices[i];
+  } else
+    for(i = 0; i < n; i++)
+      bytes[i] = (unsigned char) indices[i];
+
+  return bytes;
+}
+
+
+/* level_faces():
+   description: the faces and indices to draw for the current level of
+                detail
+   inputs: the renderer, where to put the number of faces and indices
+   output: the faces
+ */
+static face *level_faces(renderer *r, int *n_faces, int **indices){
+  lod *l;
+
+  if(r->level < 0) {
+    *n_faces = (r->obj)->n_faces;
+    *indices = (r->obj)->indices;
+    return (r->obj)->faces;
+  }
+
+  l = (r->obj)->lods + r->level;
+  *n_faces = l->n_faces;
+  *indices = l->indices;
+  return l->faces;
+}
 
 
 /* init_render():
@@ -42,14 +252,53 @@ renderer * init_render(object *o, bool back_cull, render_type t, int w, int h){
   r->obj = o;
   r->culling = back_cull;
   r->type = t;
+  r->clusters = NULL;
+  r->n_clusters = 0;
+  r->tree = NULL;
+  r->index_type = GL_UNSIGNED_INT;
+  r->index_size = sizeof(int);
+  r->indices = NULL;
+  r->lod_indices = NULL;
+  r->tree_indices = NULL;
+  r->index_bytes_before = r->index_bytes_after = 0;
+  r->buffer_bytes = 0;
+  r->groups = NULL;
+  r->n_groups = NULL;
+  r->instances = 1;
+  r->rasteriser = NULL;
+  r->headless = false;
+  r->dump = NULL;
+  r->width = w;
+  r->height = h;
+  r->level = -1;
+  r->radius = model_radius(o);
 
   reset_view(r);
 
+  /* the state that never changes is set once, here */
+  init_state(&r->state);
+  glShadeModel(GL_SMOOTH);
+  glCullFace(GL_BACK);
+  glDepthFunc(GL_LESS);
+  glClearColor(0,0,0,0);
+  setup_lighting(r);
+
   /* Call render type specific initialisation code */
   if(r->type==display_list)
     init_display_list(r);
-  else if(r->type==vertex_array)
+  else if(r->type==vertex_array || r->type==strip || r->type==clustered ||
+          r->type==hierarchy)
     init_vertex_array(r);
+  else if(r->type==buffer_object)
+    init_buffer_objects(r);
+  else if(r->type==multi_draw)
+    init_multi_draw(r);
+  else if(r->type==shader_program)
+    init_shader(r);
+
+  /* don't count anything drawn into the display list */
+  memset(&r->stats,0,sizeof(render_stats));
+  r->state.calls = r->state.skipped = 0;
 
   return r;
 }
@@ -59,84 +308,80 @@ renderer * init_render(object *o, bool back_cull, render_type t, int w, int h){
    description: draws the given object :)
  */
 void render(renderer * r){
-  float lightpos[] = {5.0f,5.0f,5.0f,0.0f};
-  float lightcolor[] = {1.0f, 1.0f, 1.0f, 1.0f};
-  float objectmat[] = {1.0f, 1.0f, 1.0f, 1.0f};
-  float zero[] = {0.0f, 0.0f, 0.0f, 1.0f};
-  GLfloat matrix[4][4];
+  float rotation[16];
 
   if(r == NULL) return;
 
-  /* FIX ME Dirty hack to stop resize bug */
-  resize(r,r->width,r->height);
-
-  /* Enable it depending on the desired setting */
-  if(r->culling == true)
-    glEnable(GL_CULL_FACE);
-  else
-    glDisable(GL_CULL_FACE);
-
-  glMatrixMode(GL_MODELVIEW);
-  glLoadIdentity();
-
-  /* Setup the viewer transform */
-  gluLookAt(0.0,0.0,5.0 * r->zoom,
-            0.0,0.0,0.0,
-            0.0,1.0,0.0);
-
-  /* Clear everything to 0,0,0,0 */
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-  /* Setup the lighting */
-  glLightModelfv(GL_LIGHT_MODEL_AMBIENT, zero);
-  glLightfv(GL_LIGHT0, GL_POSITION, lightpos);
-  glLightfv(GL_LIGHT0, GL_DIFFUSE, lightcolor);
-  glEnable(GL_LIGHT0);
-
-  /* Setup the colours on the object */
-  glMaterialfv(GL_FRONT, GL_DIFFUSE, objectmat);
-  glMaterialfv(GL_FRONT, GL_SPECULAR, zero);
-  glMaterialf(GL_FRONT, GL_SHININESS, 0);
-
-  /* Draw the object */
-  glPushMatrix();
-
-  /* insert transforms here! */
-  /*if((r->quat[0] == 0) &&
-     (r->quat[1] == 0) &&
-     (r->quat[2] == 0) &&
-     (r->quat[3] == 0)){*/
-
-      // rotate the angles
-
-  build_rotmatrix(matrix,r->quat);
-  glMultMatrixf(&matrix[0][0]);
-
-  glMultMatrixf(&(r->rot_history[0][0]));
-
-  if(r->rot_axis == x)
-    glRotatef(r->angle,1,0,0);
-  else if(r->rot_axis == y)
-    glRotatef(r->angle,0,1,0);
-  else if(r->rot_axis == z)
-    glRotatef(r->angle,0,0,1);
-
+  /* these go through the state cache, so after the first frame they're
+     only sent when they change */
+  state_enable(&r->state,GL_DEPTH_TEST,r->type != software);
+  state_enable(&r->state,GL_COLOR_MATERIAL,true);
+  state_enable(&r->state,GL_LIGHTING,true);
+  state_enable(&r->state,GL_CULL_FACE,r->culling);
+
+  /* the whole transform is put together here and loaded in one go: the
+     eye backed off along z, the trackball's quaternion, the rotations
+     done about other axes, then the one going on now */
+  mat_identity(r->modelview);
+  mat_translate(r->modelview,0.0f,0.0f,-EYE_DISTANCE * r->zoom);
+  quat_to_matrix(rotation,r->quat);
+  mat_multiply(r->modelview,r->modelview,rotation);
+  mat_multiply(r->modelview,r->modelview,r->rot_history);
+  rotate_axis(r->modelview,r->angle,r->rot_axis);
+
+  memcpy(r->draw_matrix,r->modelview,sizeof(r->modelview));
+  dequantise(r,r->draw_matrix);
+  glLoadMatrixf(r->draw_matrix);
+
+  /* Clear everything to 0,0,0,0. the software rasteriser covers the whole
+     window anyway */
+  if(r->type != software)
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+  choose_level(r);
+  if(r->level >= 0)
+    r->stats.simplified++;
 
   /* Render the object using desired method */
   if(r->type == normal)
     render_normal(r);
-  else if(r->type == display_list)
-    glCallList(r->dl_index);
+  else if(r->type == display_list) {
+    glCallList(r->dl_index + r->level + 1);
+    state_forget_colour(&r->state);
+    r->stats.draw_calls++;
+  } else if(r->type == clustered)
+    render_clusters(r);
+  else if(r->type == hierarchy)
+    render_hierarchy(r);
+  else if(r->type == multi_draw)
+    render_multi_draw(r);
+  else if(r->type == shader_program)
+    render_shader(r);
+  else if(r->type == software)
+    render_software(r);
   else
     render_vertex_array(r);
 
-  glPopMatrix();
+  /* the colour array leaves the current colour as whatever came last */
+  if((r->obj)->colours != NULL)
+    state_forget_colour(&r->state);
+
+  r->stats.frames++;
+
+  /* read the frame back before it's swapped away */
+  if(r->dump != NULL)
+    capture_frame(r->dump,r->width,r->height);
+
   glFlush();
-  glutSwapBuffers();
+
+  /* without a window, wait for the frame to be drawn like the swap would */
+  if(r->headless == true)
+    glFinish();
+  else
+    glutSwapBuffers();
 }
 
 void reset_view(renderer *r){
-  int i,j;
   r->zoom = 1.0;
 
   /* Zero the quaternion so it doesn't affect anything */
@@ -145,14 +390,13 @@ void reset_view(renderer *r){
   r->angle = 0;
 
   /* Load identity */
-  for(i =0; i < 4; i++)
-    for(j =0; j < 4; j++)
-      r->rot_history[i][j] = (i == j) ? 1.0 : 0.0;
+  mat_identity(r->rot_history);
 }
 
 
 /* resize():
-   description: handles the resizing (and init) of the window or viewport
+   description: handles the resizing of the window or viewport. only
+                called when the window really changes size
    inputs: width and height
  */
 void resize(renderer * r, int w,int h){
@@ -162,27 +406,16 @@ void resize(renderer * r, int w,int h){
   r->height = h;
 
   glViewport(0,0,r->width,r->height);
+  mat_perspective(r->projection,FIELD_OF_VIEW,1.0f,1.0f,40.0f);
   glMatrixMode(GL_PROJECTION);
-  glLoadIdentity();
-  gluPerspective(60.0, 1.0, 1.0, 40.0);
-
-  /* Enable stuff */
-  glEnable(GL_DEPTH_TEST);
-  glEnable(GL_COLOR_MATERIAL);
-  glEnable(GL_LIGHTING);
-
-  /* Use Gouraud shading */
-  glShadeModel(GL_SMOOTH);
-
-  /* Set the face to cull */
-  glCullFace(GL_BACK);
-
-  /* set the debth test func */
-  glDepthFunc(GL_LESS);
+  glLoadMatrixf(r->projection);
+  glMatrixMode(GL_MODELVIEW);
 
-  /* Kinda redudant, but what the hey! */
-  glClearColor(0,0,0,0);
-  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  if(r->rasteriser != NULL && resize_raster(r->rasteriser,w,h) == false){
+    fprintf(stderr,"Error: unable to allocate memory for the software "
+            "framebuffer\n");
+    exit(1);
+  }
 }
 
 
@@ -211,18 +444,8 @@ void set_rotation(renderer * r,float da,axis rot){
   if(r == NULL) return;
 
   if(r->rot_axis != rot) {
-    /* save the history, use the texture matrix stack */
-    glMatrixMode(GL_TEXTURE);
-    glLoadMatrixf(&(r->rot_history[0][0]));
-
-    if(r->rot_axis == x)
-      glRotatef(r->angle,1,0,0);
-    else if(r->rot_axis == y)
-      glRotatef(r->angle,0,1,0);
-    else if(r->rot_axis == z)
-      glRotatef(r->angle,0,0,1);
-
-    glGetFloatv(GL_TEXTURE_MATRIX,&(r->rot_history[0][0]));
+    /* save the history */
+    rotate_axis(r->rot_history,r->angle,r->rot_axis);
 
     /* change the rotation */
     r->rot_axis = rot;
@@ -236,6 +459,11 @@ void set_rotation(renderer * r,float da,axis rot){
 void set_zoom(renderer * r,float dz) {
   if(r == NULL) return;
   r->zoom += dz;
+
+  if(r->zoom < MIN_ZOOM)
+    r->zoom = MIN_ZOOM;
+  else if(r->zoom > MAX_ZOOM)
+    r->zoom = MAX_ZOOM;
 }
 
 void set_culling(renderer * r, bool cull) {
@@ -243,30 +471,152 @@ void set_culling(renderer * r, bool cull) {
 }
 
 
+/* set_clusters():
+   description: gives the renderer the clusters to draw in clustered mode
+   inputs: the clusters from build_clusters() and how many there are
+ */
+void set_clusters(renderer * r, cluster *c, int n) {
+  if(r == NULL) return;
+  r->clusters = c;
+  r->n_clusters = n;
+}
+
+
+/* set_instances():
+   description: sets how many copies of the model the shader render type
+                draws
+   inputs: the number of copies, at least 1
+ */
+void set_instances(renderer * r, int n) {
+  if(r == NULL) return;
+  r->instances = n < 1 ? 1 : n;
+}
+
+
+/* set_bvh():
+   description: gives the renderer the hierarchy to draw in hierarchy mode
+   inputs: the hierarchy from build_bvh()
+ */
+void set_bvh(renderer * r, bvh *tree) {
+  if(r == NULL) return;
+  r->tree = tree;
+  r->tree_indices = narrow_indices(r,tree->indices,tree->n_indices);
+}
+
+
+/* set_headless():
+   description: says whether there's a window to swap the frames into
+   inputs: true if there isn't one
+ */
+void set_headless(renderer * r, bool headless) {
+  if(r == NULL) return;
+  r->headless = headless;
+}
+
+
+/* set_dumper():
+   description: gives the renderer somewhere to save the frames it draws
+   inputs: the dumper from create_dumper()
+ */
+void set_dumper(renderer * r, dumper *d) {
+  if(r == NULL) return;
+  r->dump = d;
+}
+
+
+/* set_raster():
+   description: gives the renderer the rasteriser to draw with in software
+                mode, and makes its buffers the size of the window
+   inputs: the rasteriser from create_raster()
+ */
+void set_raster(renderer * r, raster *rs) {
+  if(r == NULL) return;
+  r->rasteriser = rs;
+  resize(r,r->width,r->height);
+}
+
+
+/* print_render_stats():
+   description: prints the draw calls per frame, how many clusters or
+                hierarchy boxes were culled, how often a simpler level
+                of detail was drawn and how many state calls were sent and
+                skipped, to stderr (stdout is for the fps). then starts
+                counting again
+ */
+void print_render_stats(renderer * r) {
+  render_stats *s;
+
+  if(r == NULL || r->stats.frames == 0) return;
+  s = &r->stats;
+
+  fprintf(stderr,"render: %.1f draw calls per frame",
+          (float) s->draw_calls / s->frames);
+
+  if(s->clusters > 0)
+    fprintf(stderr,", %.1f clusters per frame, %.1f%% outside the view, "
+            "%.1f%% facing away",(float) s->clusters / s->frames,
+            100.0f * s->outside / s->clusters,100.0f * s->back / s->clusters);
+
+  if(s->nodes > 0)
+    fprintf(stderr,", %.1f nodes tested and %.1f of %d leaves drawn per "
+            "frame",(float) s->nodes / s->frames,(float) s->leaves / s->frames,
+            r->tree ? r->tree->n_leaves : 0);
+
+  if(s->triangles > 0)
+    fprintf(stderr,", %.1f triangles rasterised per frame",
+            (float) s->triangles / s->frames);
+
+  if(s->simplified > 0)
+    fprintf(stderr,", %.1f%% of frames simplified",
+            100.0f * s->simplified / s->frames);
+
+  fprintf(stderr,", %.1f state calls per frame (%.1f skipped)",
+          (float) r->state.calls / s->frames,
+          (float) r->state.skipped / s->frames);
+
+  fprintf(stderr,"\n");
+
+  memset(s,0,sizeof(render_stats));
+  r->state.calls = r->state.skipped = 0;
+}
+
+
 /* render_normal():
    description: draws the object using the normal rendering technique.
                 ie: without any fancy rendering
  */
 void render_normal(renderer * r){
-  int i,j;
-  face f;
+  int i,j,n_faces;
+  int *all_indices, *indices;
+  unsigned char *colours = (r->obj)->colours;
+  face f, *faces;
   vertex v;
 
+  faces = level_faces(r,&n_faces,&all_indices);
+
   /* draw our model*/
-  for(i=0;i<(r->obj)->n_faces;i++){
-    f = (r->obj)->faces[i];
+  for(i=0;i<n_faces;i++){
+    f = faces[i];
+    indices = all_indices + f.first_index;
 
     glBegin(f.draw_mode);
-    glColor3f(f.colour[0],f.colour[1],f.colour[2]);
+    state_colour(&r->state,f.colour[0],f.colour[1],f.colour[2]);
 
     for(j=0;j<f.n_vertices;j++){
-      v = (r->obj)->vertices[f.vertex_indices[j]];
+      v = (r->obj)->vertices[indices[j]];
+      if(colours != NULL)
+        glColor4ubv(colours + 4 * indices[j]);
       glNormal3f(v.normX,v.normY,v.normZ);
       glVertex3f(v.x,v.y,v.z);
     }
 
     glEnd();
+
+    if(colours != NULL)
+      state_forget_colour(&r->state);
   }
+
+  r->stats.draw_calls += n_faces;
 }
 
 
@@ -275,17 +625,224 @@ void render_normal(renderer * r){
                 earlier
  */
 void render_vertex_array(renderer * r){
-  int i;
-  face f;
+  int i, n_faces, *ints;
+  face f, *faces;
+  void *indices;
+
+  faces = level_faces(r,&n_faces,&ints);
+  indices = r->level < 0 ? r->indices : r->lod_indices[r->level];
 
-  for(i =0 ; i < (r->obj)->n_faces ; i++) {
-    f = (r->obj)->faces[i];
+  for(i =0 ; i < n_faces ; i++) {
+    f = faces[i];
 
-    glColor3f(f.colour[0],f.colour[1],f.colour[2]);
+    state_colour(&r->state,f.colour[0],f.colour[1],f.colour[2]);
 
     /* The machine that does the work. Draw I Say! */
-    glDrawElements(f.draw_mode,f.n_vertices,GL_UNSIGNED_INT,f.vertex_indices);
+    glDrawElements(f.draw_mode,f.n_vertices,r->index_type,
+                   INDEX_AT(r,indices,f.first_index));
+  }
+
+  r->stats.draw_calls += n_faces;
+}
+
+
+/* render_clusters():
+   description: draws the object using vertex arrays, skipping clusters
+                that are outside the view or (when culling) facing away.
+                runs of visible clusters next to each other are drawn with
+                one call
+ */
+void render_clusters(renderer * r){
+  cluster_view view;
+  cluster *c;
+  face *f;
+  int i, first = 0, count = 0, last_face = -1;
+  cluster_cull cull;
+
+  setup_cluster_view(&view,r->modelview,r->projection);
+
+  for(i = 0; i < r->n_clusters; i++) {
+    c = r->clusters + i;
+    cull = cull_cluster(c,&view,r->culling);
+
+    if(cull == cluster_outside)
+      r->stats.outside++;
+    else if(cull == cluster_back)
+      r->stats.back++;
+
+    if(cull != cluster_visible)
+      continue;
+
+    /* carry on the run if we can */
+    if(count > 0 && c->face == last_face && c->first_index == first + count) {
+      count += c->n_indices;
+      continue;
+    }
+
+    if(count > 0) {
+      f = (r->obj)->faces + last_face;
+      glDrawElements(f->draw_mode,count,r->index_type,
+                     INDEX_AT(r,r->indices,first));
+      r->stats.draw_calls++;
+    }
+
+    f = (r->obj)->faces + c->face;
+    if(c->face != last_face)
+      state_colour(&r->state,f->colour[0],f->colour[1],f->colour[2]);
+
+    last_face = c->face;
+    first = c->first_index;
+    count = c->n_indices;
+  }
+
+  if(count > 0) {
+    f = (r->obj)->faces + last_face;
+    glDrawElements(f->draw_mode,count,r->index_type,
+                   INDEX_AT(r,r->indices,first));
+    r->stats.draw_calls++;
+  }
+
+  r->stats.clusters += r->n_clusters;
+}
+
+
+/* draw_run():
+   description: draws a run of a face's indices from the hierarchy, or adds
+                it to the one waiting to be drawn if it carries straight on
+                from it
+   inputs: the renderer, the run (NULL to draw what's waiting), the run
+           waiting to be drawn
+ */
+static void draw_run(renderer * r, bvh_run *run, bvh_run *waiting){
+  face *f;
+
+  if(run != NULL && waiting->n_indices > 0 && run->face == waiting->face &&
+     run->first_index == waiting->first_index + waiting->n_indices) {
+    waiting->n_indices += run->n_indices;
+    return;
+  }
+
+  if(waiting->n_indices > 0) {
+    f = (r->obj)->faces + waiting->face;
+    glDrawElements(f->draw_mode,waiting->n_indices,r->index_type,
+                   INDEX_AT(r,r->tree_indices,waiting->first_index));
+    r->stats.draw_calls++;
+  }
+
+  if(run == NULL) return;
+
+  f = (r->obj)->faces + run->face;
+  if(waiting->n_indices == 0 || run->face != waiting->face)
+    state_colour(&r->state,f->colour[0],f->colour[1],f->colour[2]);
+  *waiting = *run;
+}
+
+
+/* render_hierarchy():
+   description: draws the object using vertex arrays, walking down the
+                hierarchy and skipping every subtree whose box is outside
+                the view. once a box is inside the view nothing under it
+                needs testing. leaves next to each other draw with one call
+                per face where they can
+ */
+void render_hierarchy(renderer * r){
+  cluster_view view;
+  bvh *tree = r->tree;
+  bvh_node *n;
+  bvh_run waiting;
+  bvh_cull cull;
+  int i, j, inside_until = 0;
+
+  if(tree == NULL) return;
+
+  setup_cluster_view(&view,r->modelview,r->projection);
+
+  waiting.n_indices = 0;
+  waiting.face = -1;
+
+  for(i = 0; i < tree->n_nodes; ) {
+    n = tree->nodes + i;
+
+    if(i >= inside_until) {
+      cull = cull_bvh_node(n,&view);
+      r->stats.nodes++;
+
+      if(cull == bvh_outside) {
+        i = n->count ? i + 1 : n->offset;
+        continue;
+      }
+
+      if(cull == bvh_inside && n->count == 0)
+        inside_until = n->offset;
+    }
+
+    if(n->count > 0) {
+      for(j = n->offset; j < n->offset + n->count; j++)
+        draw_run(r,tree->runs + j,&waiting);
+      r->stats.leaves++;
+    }
+
+    i++;
+  }
+
+  for(i = tree->first_extra; i < tree->n_runs; i++)
+    draw_run(r,tree->runs + i,&waiting);
+
+  draw_run(r,NULL,&waiting);
+}
+
+
+/* vertex_pointers():
+   description: points GL at the vertices, either the object's own or the
+                squashed ones, and their colours if they've been baked
+   inputs: the renderer, where the vertices and colours start (in memory,
+           or in the bound buffer)
+ */
+static void vertex_pointers(renderer * r, char *base, char *colours){
+  /* baked colours sit in their own array, as there's no interleaved
+     format with normals and colours. glInterleavedArrays() turns the
+     colour array off, so it goes on afterwards */
+  if((r->obj)->colours != NULL) {
+    glEnableClientState(GL_COLOR_ARRAY);
+    glColorPointer(4,GL_UNSIGNED_BYTE,0,colours);
   }
+
+  /* Why mess around with glVertexPointer and glNormalPoint when GL gives
+     you this function to work with? */
+  if((r->obj)->qvertices == NULL) {
+    glInterleavedArrays(GL_N3F_V3F,0,base);
+    if((r->obj)->colours != NULL)
+      glEnableClientState(GL_COLOR_ARRAY);
+    return;
+  }
+
+  /* the squashed vertices don't fit any of the interleaved formats. their
+     normals lose a little length, and get scaled by dequantise(), so GL
+     has to put them right */
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_NORMAL_ARRAY);
+  glVertexPointer(3,GL_SHORT,sizeof(qvertex),base + offsetof(qvertex,x));
+  glNormalPointer(GL_BYTE,sizeof(qvertex),base + offsetof(qvertex,normX));
+  glEnable(GL_NORMALIZE);
+}
+
+
+/* init_indices():
+   description: makes the index buffers the vertex array modes draw from,
+                for the model and each level of detail
+ */
+static void init_indices(renderer * r){
+  object *o = r->obj;
+  int i;
+
+  /* most models have few enough vertices for smaller indices */
+  choose_index_type(r);
+  r->indices = narrow_indices(r,o->indices,o->n_indices);
+
+  r->lod_indices = (void **) malloc(sizeof(void *) * (o->n_lods + 1));
+  for(i = 0; i < o->n_lods; i++)
+    r->lod_indices[i] = narrow_indices(r,o->lods[i].indices,
+                                       o->lods[i].n_indices);
 }
 
 
@@ -293,38 +850,394 @@ void render_vertex_array(renderer * r){
    description: prepares the render for drawing using vertex arrays
  */
 void init_vertex_array(renderer * r){
-  float *vertices;
-
-  /* recast our vertex struct as an array of floats
-     fortunetly the vertex struct is setup in such a way that this works */
-  vertices = (float *) (r->obj)->vertices;
-
-#ifdef INDEX_OPTIMISATION
-  /* rejig the object so we can save time on calls! */
-  optimise(obj);
-#endif /* INDEX_OPTIMISATION */
+  object *o = r->obj;
 
   /* Enable the vertex and normal array states so GL knows what to do */
   glEnableClientState(GL_VERTEX_ARRAY);
   glEnableClientState(GL_NORMAL_ARRAY);
 
-  /* Why mess around with glVertexPointer and glNormalPoint when GL gives
-     you this function to work with? */
-  /* Setup the array ready for use */
-  glInterleavedArrays(GL_N3F_V3F,0,vertices);
+  /* Setup the array ready for use. fortunetly the vertex struct is setup
+     in such a way that it can be recast as an array of floats */
+  if(o->qvertices != NULL)
+    vertex_pointers(r,(char *) o->qvertices,(char *) o->colours);
+  else
+    vertex_pointers(r,(char *) o->vertices,(char *) o->colours);
+
+  init_indices(r);
+}
+
+
+/* upload_indices():
+   description: copies an index buffer into the bound element buffer, and
+                frees it if it was the renderer's copy
+   inputs: the renderer, the indices, how many, where in the buffer
+   output: where they went, as a pointer GL understands
+ */
+static void *upload_indices(renderer * r, void *indices, int n, long offset){
+  glBufferSubData(GL_ELEMENT_ARRAY_BUFFER,offset,(long) r->index_size * n,
+                  indices);
+
+  if(r->index_type != GL_UNSIGNED_INT)
+    free(indices);
 
+  return (void *) offset;
+}
+
+
+/* upload_buffers():
+   description: copies the vertices, their colours and the index buffers
+                to the card, and leaves the buffers bound. the levels of
+                detail go in the same index buffer as the model, and the
+                index pointers become offsets into it
+   output: where the colours start in the vertex buffer
+ */
+static long upload_buffers(renderer * r){
+  object *o = r->obj;
+  long vertex_bytes, colour_bytes, index_bytes, offset;
+  int i;
+
+  glGenBuffers(2,r->buffers);
+
+  if(o->qvertices != NULL)
+    vertex_bytes = (long) sizeof(qvertex) * o->n_vertices;
+  else
+    vertex_bytes = (long) sizeof(vertex) * o->n_vertices;
+
+  /* the colours go straight after the vertices */
+  colour_bytes = o->colours != NULL ? 4L * o->n_vertices : 0;
+
+  glBindBuffer(GL_ARRAY_BUFFER,r->buffers[0]);
+  glBufferData(GL_ARRAY_BUFFER,vertex_bytes + colour_bytes,NULL,
+               GL_STATIC_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER,0,vertex_bytes,o->qvertices != NULL ?
+                  (void *) o->qvertices : (void *) o->vertices);
+  if(colour_bytes > 0)
+    glBufferSubData(GL_ARRAY_BUFFER,vertex_bytes,colour_bytes,o->colours);
+
+  index_bytes = (long) r->index_size * o->n_indices;
+  for(i = 0; i < o->n_lods; i++)
+    index_bytes += (long) r->index_size * o->lods[i].n_indices;
+
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER,r->buffers[1]);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER,index_bytes,NULL,GL_STATIC_DRAW);
+
+  r->indices = upload_indices(r,r->indices,o->n_indices,0);
+  offset = (long) r->index_size * o->n_indices;
+  for(i = 0; i < o->n_lods; i++){
+    r->lod_indices[i] = upload_indices(r,r->lod_indices[i],
+                                       o->lods[i].n_indices,offset);
+    offset += (long) r->index_size * o->lods[i].n_indices;
+  }
+
+  r->buffer_bytes = vertex_bytes + colour_bytes + index_bytes;
+  return vertex_bytes;
+}
+
+
+/* init_buffer_objects():
+   description: prepares the render for drawing from buffer objects. the
+                vertices and indices are copied to the card once, so
+                drawing doesn't read them from our memory every frame
+ */
+void init_buffer_objects(renderer * r){
+  long colours;
+
+  init_vertex_array(r);
+  colours = upload_buffers(r);
+  vertex_pointers(r,NULL,(char *) colours);
+}
+
+
+/* init_shader():
+   description: prepares the render for drawing with the lighting shader.
+                the buffers are the same as for buffer objects, but the
+                vertex array object remembers them as generic attributes.
+                squashed positions go in as they are, dequantise() takes
+                care of them like for the other modes
+ */
+void init_shader(renderer * r){
+#ifndef __APPLE__
+  object *o = r->obj;
+  long colours;
+#endif
+
+  if(shaders_supported() == false || build_shader(&r->program) == false) {
+    fprintf(stderr,"Error: unable to build the shaders, they need OpenGL "
+            "3.1 or later\n");
+    exit(1);
+  }
+
+  /* never gets here on OS X, which has no vertex array objects */
+#ifndef __APPLE__
+  glGenVertexArrays(1,&r->vao);
+  glBindVertexArray(r->vao);
+
+  init_indices(r);
+  colours = upload_buffers(r);
+
+  if(o->qvertices != NULL) {
+    glVertexAttribPointer(SHADER_POSITION,3,GL_SHORT,GL_FALSE,
+                          sizeof(qvertex),(void *) offsetof(qvertex,x));
+    glVertexAttribPointer(SHADER_NORMAL,3,GL_BYTE,GL_TRUE,sizeof(qvertex),
+                          (void *) offsetof(qvertex,normX));
+  } else {
+    glVertexAttribPointer(SHADER_POSITION,3,GL_FLOAT,GL_FALSE,sizeof(vertex),
+                          (void *) offsetof(vertex,x));
+    glVertexAttribPointer(SHADER_NORMAL,3,GL_FLOAT,GL_FALSE,sizeof(vertex),
+                          (void *) offsetof(vertex,normX));
+  }
+  glEnableVertexAttribArray(SHADER_POSITION);
+  glEnableVertexAttribArray(SHADER_NORMAL);
+
+  /* without baked colours, each face's colour is set before it's drawn */
+  if(o->colours != NULL) {
+    glVertexAttribPointer(SHADER_COLOUR,4,GL_UNSIGNED_BYTE,GL_TRUE,0,
+                          (void *) colours);
+    glEnableVertexAttribArray(SHADER_COLOUR);
+  }
+
+  glBindVertexArray(0);
+#endif
+}
+
+
+/* render_shader():
+   description: draws the object with the lighting shader, every copy of
+                each face at once with instancing. the copies are laid out
+                in a square grid, two model sizes apart
+ */
+void render_shader(renderer * r){
+#ifndef __APPLE__
+  float lightpos[] = {5.0f,5.0f,5.0f};
+  int i, n_faces, *ints, columns;
+  face *f, *faces;
+  void *indices;
+  float l;
+
+  faces = level_faces(r,&n_faces,&ints);
+  indices = r->level < 0 ? r->indices : r->lod_indices[r->level];
+
+  for(columns = 1; columns * columns < r->instances; columns++);
+
+  /* the light is directional, and was set under the identity, so it's the
+     same in eye space */
+  l = sqrtf(lightpos[0] * lightpos[0] + lightpos[1] * lightpos[1] +
+            lightpos[2] * lightpos[2]);
+
+  glUseProgram(r->program.program);
+  glUniformMatrix4fv(r->program.modelview,1,GL_FALSE,r->draw_matrix);
+  glUniformMatrix4fv(r->program.projection,1,GL_FALSE,r->projection);
+  glUniform3f(r->program.light,lightpos[0] / l,lightpos[1] / l,
+              lightpos[2] / l);
+  glUniform1i(r->program.columns,columns);
+  glUniform1i(r->program.rows,(r->instances + columns - 1) / columns);
+  glUniform1f(r->program.spacing,2.0f * r->radius);
+  glBindVertexArray(r->vao);
+
+  for(i = 0; i < n_faces; i++) {
+    f = faces + i;
+
+    if((r->obj)->colours == NULL)
+      glVertexAttrib4f(SHADER_COLOUR,f->colour[0],f->colour[1],f->colour[2],
+                       1.0f);
+
+    glDrawElementsInstanced(f->draw_mode,f->n_vertices,r->index_type,
+                            INDEX_AT(r,indices,f->first_index),r->instances);
+  }
+
+  glBindVertexArray(0);
+  glUseProgram(0);
+
+  r->stats.draw_calls += n_faces;
+#endif
+}
+
+
+/* render_software():
+   description: draws the object on the cpu with the rasteriser, then
+                copies the picture into the window. the one copy counts as
+                the draw call
+ */
+void render_software(renderer * r){
+  raster *rs = r->rasteriser;
+
+  if(rs == NULL) return;
+
+  r->stats.triangles += draw_raster(rs,r->level,r->modelview,r->projection,
+                                    r->culling);
+
+  glWindowPos2i(0,0);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH,rs->stride);
+  glDrawPixels(rs->width,rs->height,GL_RGBA,GL_UNSIGNED_BYTE,rs->colour);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH,0);
+
+  r->stats.draw_calls++;
+}
+
+
+/* a face being sorted into its group */
+typedef struct {
+  GLenum draw_mode;
+  float *colour;
+  int first_index;
+  int n_vertices;
+} group_face;
+
+
+/* compare_group_faces():
+   description: qsort comparison putting faces with the same draw mode and
+                colour together, and then in the order they're drawn from
+                the index buffer
+ */
+static int compare_group_faces(const void *a, const void *b){
+  const group_face *fa = (const group_face *) a;
+  const group_face *fb = (const group_face *) b;
+  int i;
+
+  if(fa->draw_mode != fb->draw_mode)
+    return fa->draw_mode < fb->draw_mode ? -1 : 1;
+
+  for(i = 0; i < 3; i++)
+    if(fa->colour[i] != fb->colour[i])
+      return fa->colour[i] < fb->colour[i] ? -1 : 1;
+
+  return fa->first_index - fb->first_index;
+}
+
+
+/* build_groups():
+   description: sorts faces into groups with the same draw mode and
+                colour. faces of separate triangles or quads that follow
+                on from each other in the index buffer become one range
+   inputs: the renderer, the faces, how many, the indices they're drawn
+           from (in the renderer's index type), where to put the number of
+           groups
+   output: the groups
+ */
+static face_group *build_groups(renderer * r, face *faces, int n_faces,
+                                void *indices, int *n_groups){
+  group_face *sorted;
+  face_group *groups, *g;
+  GLsizei *counts;
+  const GLvoid **starts;
+  int i, end = 0;
+
+  sorted = (group_face *) malloc(sizeof(group_face) * (n_faces + 1));
+  groups = (face_group *) malloc(sizeof(face_group) * (n_faces + 1));
+  counts = (GLsizei *) malloc(sizeof(GLsizei) * (n_faces + 1));
+  starts = (const GLvoid **) malloc(sizeof(GLvoid *) * (n_faces + 1));
+  if(sorted == NULL || groups == NULL || counts == NULL || starts == NULL){
+    fprintf(stderr,"Error: unable to allocate memory for the face groups\n");
+    exit(1);
+  }
+
+  for(i = 0; i < n_faces; i++){
+    sorted[i].draw_mode = faces[i].draw_mode;
+    sorted[i].colour = faces[i].colour;
+    sorted[i].first_index = faces[i].first_index;
+    sorted[i].n_vertices = faces[i].n_vertices;
+  }
+  qsort(sorted,n_faces,sizeof(group_face),compare_group_faces);
+
+  *n_groups = 0;
+  g = NULL;
+  for(i = 0; i < n_faces; i++){
+    if(g == NULL || sorted[i].draw_mode != g->draw_mode ||
+       sorted[i].colour[0] != g->colour[0] ||
+       sorted[i].colour[1] != g->colour[1] ||
+       sorted[i].colour[2] != g->colour[2]) {
+      g = groups + (*n_groups)++;
+      g->draw_mode = sorted[i].draw_mode;
+      g->colour[0] = sorted[i].colour[0];
+      g->colour[1] = sorted[i].colour[1];
+      g->colour[2] = sorted[i].colour[2];
+      g->n_ranges = 0;
+      g->counts = counts + i;
+      g->starts = starts + i;
+    } else if((g->draw_mode == GL_TRIANGLES || g->draw_mode == GL_QUADS) &&
+              sorted[i].first_index == end) {
+      /* carries straight on from the last one */
+      g->counts[g->n_ranges - 1] += sorted[i].n_vertices;
+      end += sorted[i].n_vertices;
+      continue;
+    }
+
+    g->counts[g->n_ranges] = sorted[i].n_vertices;
+    g->starts[g->n_ranges++] = INDEX_AT(r,indices,sorted[i].first_index);
+    end = sorted[i].first_index + sorted[i].n_vertices;
+  }
+
+  free(sorted);
+  return groups;
+}
+
+
+/* init_multi_draw():
+   description: prepares the render for drawing each group of faces with
+                the same draw mode and colour with one call, for the model
+                and each level of detail
+ */
+void init_multi_draw(renderer * r){
+  object *o = r->obj;
+  int i;
+
+  init_vertex_array(r);
+
+  r->groups = (face_group **) malloc(sizeof(face_group *) * (o->n_lods + 1));
+  r->n_groups = (int *) malloc(sizeof(int) * (o->n_lods + 1));
+  if(r->groups == NULL || r->n_groups == NULL){
+    fprintf(stderr,"Error: unable to allocate memory for the face groups\n");
+    exit(1);
+  }
+
+  r->groups[0] = build_groups(r,o->faces,o->n_faces,r->indices,
+                              r->n_groups);
+  for(i = 0; i < o->n_lods; i++)
+    r->groups[i + 1] = build_groups(r,o->lods[i].faces,o->lods[i].n_faces,
+                                    r->lod_indices[i],r->n_groups + i + 1);
+}
+
+
+/* render_multi_draw():
+   description: draws the object using vertex arrays, one call for each
+                group of faces with the same draw mode and colour
+ */
+void render_multi_draw(renderer * r){
+  face_group *g = r->groups[r->level + 1];
+  int i, n = r->n_groups[r->level + 1];
+
+  for(i = 0; i < n; i++, g++){
+    state_colour(&r->state,g->colour[0],g->colour[1],g->colour[2]);
+    glMultiDrawElements(g->draw_mode,g->counts,r->index_type,g->starts,
+                        g->n_ranges);
+  }
+
+  r->stats.draw_calls += n;
 }
 
 
 /* init_display_list():
-   description: prepares a display list for drawing the object
+   description: prepares a display list for drawing the object, and each of
+                its levels of detail
  */
 void init_display_list(renderer * r){
-  r->dl_index = glGenLists(1);
+  int i;
+
+  /* one list for the model, then one for each level of detail */
+  r->dl_index = glGenLists((r->obj)->n_lods + 1);
 
-  glNewList(r->dl_index,GL_COMPILE);
+  for(i = -1; i < (r->obj)->n_lods; i++){
+    r->level = i;
+    /* the colours must all go into the list, not be skipped because
+       they were set before it */
+    state_forget_colour(&r->state);
+    glNewList(r->dl_index + i + 1,GL_COMPILE);
 
-  render_normal(r);
+    render_normal(r);
+
+    glEndList();
+  }
 
-  glEndList();
+  r->level = -1;
+  state_forget_colour(&r->state);
 }
@@ -13,6 +13,45 @@
 #include "common.h"
 #include "platform.h"
 #include "object.h"
+#include "cluster.h"
+#include "bvh.h"
+#include "shader.h"
+#include "glstate.h"
+#include "raster.h"
+#include "dump.h"
+
+/* counts of what's been drawn since the stats were last printed */
+typedef struct {
+  long frames;
+  long draw_calls;
+
+  /* clusters looked at, and how many were outside the view or facing
+     away from the eye */
+  long clusters;
+  long outside;
+  long back;
+
+  /* hierarchy nodes tested against the view, and leaves drawn */
+  long nodes;
+  long leaves;
+
+  /* triangles filled in by the software rasteriser */
+  long triangles;
+
+  /* frames drawn with a simpler level of detail */
+  long simplified;
+} render_stats;
+
+/* faces with the same draw mode and colour, drawn with one call */
+typedef struct {
+  GLenum draw_mode;
+  float colour[3];
+
+  /* how many indices each range has, and where it starts */
+  int n_ranges;
+  GLsizei *counts;
+  const GLvoid **starts;
+} face_group;
 
 typedef struct {
     /* Static globals we want hanging around */
@@ -24,13 +63,77 @@ typedef struct {
 
     /* Store the quaternion for changing the rotation of the object */
     float quat[4];
-    GLfloat rot_history[4][4];
+    float rot_history[16];
     float angle;
     axis  rot_axis;
     float zoom;
 
+    /* the model's transform, worked out on the cpu each frame: the one the
+       model's vertices go through, the one loaded into GL (the same, unless
+       squashed vertices are being drawn) and the projection */
+    float modelview[16];
+    float draw_matrix[16];
+    float projection[16];
+
     /* Display List index, used when the display list option is chosen */
     int dl_index;
+
+    /* the level of detail being drawn (-1 for the model itself), and the
+       size of the model for picking it */
+    int level;
+    float radius;
+
+    /* the clusters to cull and draw, when the clustered option is chosen */
+    cluster *clusters;
+    int n_clusters;
+
+    /* the hierarchy to cull and draw, when the hierarchy option is chosen */
+    bvh *tree;
+
+    /* the index buffers the vertex array modes draw from, in the smallest
+       type that holds every vertex number. with GL_UNSIGNED_INT they're
+       the object's own */
+    GLenum index_type;
+    int index_size;
+    void *indices;
+    void **lod_indices;
+    void *tree_indices;
+
+    /* the vertex and index buffers on the card, when the buffer object
+       option is chosen. the index pointers above are then offsets into
+       the index buffer */
+    GLuint buffers[2];
+    long buffer_bytes;
+
+    /* the groups of faces for the model and each level of detail, when
+       the multi draw option is chosen */
+    face_group **groups;
+    int *n_groups;
+
+    /* the lighting program, the vertex array object holding the buffers,
+       and how many copies to draw, when the shader option is chosen */
+    shader program;
+    GLuint vao;
+    int instances;
+
+    /* true when there's no window, so nothing to swap */
+    bool headless;
+
+    /* where the frames are saved, if they are */
+    dumper *dump;
+
+    /* the rasteriser drawing the frames, when the software option is
+       chosen */
+    raster *rasteriser;
+
+    /* the GL state last set, so calls that change nothing can be skipped */
+    gl_state state;
+
+    /* how big the index buffers would be as ints, and are */
+    long index_bytes_before;
+    long index_bytes_after;
+
+    render_stats stats;
 } renderer;
 
 /* interface function prototypes */
@@ -43,5 +146,12 @@ void set_rotation(renderer *,float,axis);
 void set_zoom(renderer *,float);
 void set_culling(renderer * r, bool cull);
 void reset_view(renderer *);
+void set_clusters(renderer *,cluster *,int);
+void set_bvh(renderer *,bvh *);
+void set_instances(renderer *,int);
+void set_raster(renderer *,raster *);
+void set_headless(renderer *,bool);
+void set_dumper(renderer *,dumper *);
+void print_render_stats(renderer *);
 
 #endif /* !_CB_RENDER_H */
@@ -0,0 +1,268 @@
+/********************
+ * FILE: scan.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Functions for scanning through OFF text quickly. Whitespace and tokens
+ *     are found 16 (SSE2) or 32 (AVX2) bytes at a time, picking whichever
+ *     the cpu supports when the program starts, and runs of digits are
+ *     converted 8 at a time inside a 64 bit register. There's a plain C
+ *     version of everything for other cpus.
+ */
+
+#include <string.h> /*for memcpy*/
+
+#include "common.h"
+#include "scan.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SCAN_X86
+#include <immintrin.h>
+#endif
+
+/* anything at or below a space counts as whitespace */
+#define SPACE ' '
+
+static const char *space_scalar(const char *,const char *);
+static const char *token_scalar(const char *,const char *);
+
+/* the scanners in use, the scalar ones until we're told otherwise */
+const char *(*scan_space)(const char *,const char *) = space_scalar;
+const char *(*scan_token)(const char *,const char *) = token_scalar;
+
+static scan_mode current_mode = scan_scalar;
+
+
+/* space_scalar():
+   description: finds the first non whitespace character a byte at a time
+   inputs: the start and end of the text
+   output: pointer to the character, or the end
+ */
+static const char *space_scalar(const char *p,const char *end){
+  while(p < end && ((unsigned char) *p) <= SPACE)
+    p++;
+  return p;
+}
+
+
+/* token_scalar():
+   description: finds the first whitespace character a byte at a time
+   inputs: the start and end of the text
+   output: pointer to the character, or the end
+ */
+static const char *token_scalar(const char *p,const char *end){
+  while(p < end && ((unsigned char) *p) > SPACE)
+    p++;
+  return p;
+}
+
+
+#ifdef SCAN_X86
+
+/* space_sse2():
+   description: finds the first non whitespace character 16 bytes at a time.
+                most tokens are only a character or two apart, so the first
+                couple are checked before bothering with the vector code
+ */
+__attribute__((target("sse2")))
+static const char *space_sse2(const char *p,const char *end){
+  __m128i spaces = _mm_set1_epi8(SPACE);
+  __m128i block;
+  unsigned int mask;
+
+  if(p >= end || ((unsigned char) *p) > SPACE) return p;
+  if(++p >= end || ((unsigned char) *p) > SPACE) return p;
+
+  for(; p + 16 <= end; p += 16){
+    block = _mm_loadu_si128((const __m128i *) p);
+
+    /* a bit for every byte that isn't whitespace */
+    mask = ~_mm_movemask_epi8(
+             _mm_cmpeq_epi8(_mm_min_epu8(block,spaces),block)) & 0xffff;
+
+    if(mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+
+  return space_scalar(p,end);
+}
+
+
+/* token_sse2():
+   description: finds the first whitespace character 16 bytes at a time
+ */
+__attribute__((target("sse2")))
+static const char *token_sse2(const char *p,const char *end){
+  __m128i spaces = _mm_set1_epi8(SPACE);
+  __m128i block;
+  unsigned int mask;
+
+  for(; p + 16 <= end; p += 16){
+    block = _mm_loadu_si128((const __m128i *) p);
+
+    /* a bit for every whitespace byte */
+    mask = _mm_movemask_epi8(
+             _mm_cmpeq_epi8(_mm_min_epu8(block,spaces),block));
+
+    if(mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+
+  return token_scalar(p,end);
+}
+
+
+/* space_avx2():
+   description: as space_sse2(), but 32 bytes at a time
+ */
+__attribute__((target("avx2")))
+static const char *space_avx2(const char *p,const char *end){
+  __m256i spaces = _mm256_set1_epi8(SPACE);
+  __m256i block;
+  unsigned int mask;
+
+  if(p >= end || ((unsigned char) *p) > SPACE) return p;
+  if(++p >= end || ((unsigned char) *p) > SPACE) return p;
+
+  for(; p + 32 <= end; p += 32){
+    block = _mm256_loadu_si256((const __m256i *) p);
+
+    mask = ~(unsigned int) _mm256_movemask_epi8(
+             _mm256_cmpeq_epi8(_mm256_min_epu8(block,spaces),block));
+
+    if(mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+
+  return space_sse2(p,end);
+}
+
+
+/* token_avx2():
+   description: as token_sse2(), but 32 bytes at a time
+ */
+__attribute__((target("avx2")))
+static const char *token_avx2(const char *p,const char *end){
+  __m256i spaces = _mm256_set1_epi8(SPACE);
+  __m256i block;
+  unsigned int mask;
+
+  for(; p + 32 <= end; p += 32){
+    block = _mm256_loadu_si256((const __m256i *) p);
+
+    mask = (unsigned int) _mm256_movemask_epi8(
+             _mm256_cmpeq_epi8(_mm256_min_epu8(block,spaces),block));
+
+    if(mask != 0)
+      return p + __builtin_ctz(mask);
+  }
+
+  return token_sse2(p,end);
+}
+
+#endif /* SCAN_X86 */
+
+
+/* set_scan_mode():
+   description: picks the scanners to use
+   inputs: the mode wanted, scan_auto for the best the cpu supports
+   output: false if the cpu can't do the mode asked for
+ */
+bool set_scan_mode(scan_mode mode){
+#ifdef SCAN_X86
+  __builtin_cpu_init();
+
+  if(mode == scan_auto)
+    mode = __builtin_cpu_supports("avx2") ? scan_avx2 :
+           __builtin_cpu_supports("sse2") ? scan_sse2 : scan_scalar;
+
+  if(mode == scan_avx2 && __builtin_cpu_supports("avx2")) {
+    scan_space = space_avx2;
+    scan_token = token_avx2;
+  } else if(mode == scan_sse2 && __builtin_cpu_supports("sse2")) {
+    scan_space = space_sse2;
+    scan_token = token_sse2;
+  } else if(mode != scan_scalar)
+    return false;
+#else
+  if(mode == scan_auto)
+    mode = scan_scalar;
+  else if(mode != scan_scalar)
+    return false;
+#endif
+
+  if(mode == scan_scalar) {
+    scan_space = space_scalar;
+    scan_token = token_scalar;
+  }
+
+  current_mode = mode;
+  return true;
+}
+
+
+/* get_scan_mode():
+   description: the scanners currently in use
+ */
+scan_mode get_scan_mode(void){
+  return current_mode;
+}
+
+
+/* scan_mode_name():
+   description: a printable name for a scan mode
+ */
+const char *scan_mode_name(scan_mode mode){
+  switch(mode){
+    case scan_scalar:
+      return "scalar";
+    case scan_sse2:
+      return "sse2";
+    case scan_avx2:
+      return "avx2";
+    default:
+      return "auto";
+  }
+}
+
+
+/* parse_digits():
+   description: converts a run of up to 8 digits to a number in one go. the
+                8 bytes are loaded into a register, shifted so the digits we
+                want are at the top, then pairs, quads and octets are
+                combined with a few multiplies.
+                WARNING!!! - always reads 8 bytes from p, even if the run is
+                             shorter, so the caller must make sure they are
+                             there
+   inputs: pointer to the first digit, the number of digits (1 to 8)
+   output: the value of the digits
+ */
+unsigned int parse_digits(const char *p,int n){
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+  unsigned long long val;
+
+  memcpy(&val,p,8);
+
+  /* the first digit is in the lowest byte, so shifting left throws away
+     whatever came after the run and leaves leading zeros behind. any
+     borrowing from the subtract only moves towards those bytes */
+  val -= 0x3030303030303030ULL;
+  val <<= (8 - n) * 8;
+
+  val = (val * 10) + (val >> 8);
+  val = (((val & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+         (((val >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32))))
+        >> 32;
+
+  return (unsigned int) val;
+#else
+  unsigned int val = 0;
+
+  /* the register trick needs the first digit in the lowest byte */
+  while(n-- > 0)
+    val = val * 10 + (*p++ - '0');
+
+  return val;
+#endif
+}
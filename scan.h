@@ -0,0 +1,31 @@
+/********************
+ * FILE: scan.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for scan.c. Defines the scanner modes and contains the
+ *     prototypes for the interface functions
+ */
+
+#ifndef _CB_SCAN_H
+#define _CB_SCAN_H
+
+#include "common.h"
+
+/* the different ways of scanning text. auto picks the best one the cpu
+   supports */
+typedef enum { scan_auto, scan_scalar, scan_sse2, scan_avx2 } scan_mode;
+
+/* the scanners themselves. both take the start and end of the text.
+   scan_space returns the first non whitespace character (or the end),
+   scan_token returns the first whitespace character (or the end) */
+extern const char *(*scan_space)(const char *,const char *);
+extern const char *(*scan_token)(const char *,const char *);
+
+/* interface function prototypes */
+bool set_scan_mode(scan_mode);
+scan_mode get_scan_mode(void);
+const char *scan_mode_name(scan_mode);
+unsigned int parse_digits(const char *,int);
+#endif /* !_CB_SCAN_H */
@@ -0,0 +1,166 @@
+/********************
+ * FILE: shader.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Functions for building the GLSL program the shader render type draws
+ *     with. It lights each vertex the same way the fixed function pipeline
+ *     does with the one directional light render() sets up, so the two
+ *     look the same. Copies of the model drawn with instancing are spread
+ *     out in a grid facing the eye.
+ */
+
+#include <stdio.h>
+#include <stdlib.h> /*for malloc*/
+
+#include "common.h"
+#include "platform.h"
+#include "shader.h"
+
+/* the oldest GL with everything the shaders need (instancing in
+   particular) */
+#define SHADER_GL_MAJOR 3
+#define SHADER_GL_MINOR 1
+
+/* OS X's OpenGL headers stop at 2.1, so there's no instancing or vertex
+   array objects to build against */
+#ifndef __APPLE__
+
+/* diffuse lighting from one directional light, with no ambient or
+   specular, the same as render() sets up. instance i is moved across the
+   eye's view, a row at a time */
+static const char *vertex_source =
+  "#version 140\n"
+  "in vec3 position;\n"
+  "in vec3 normal;\n"
+  "in vec4 colour;\n"
+  "uniform mat4 modelview;\n"
+  "uniform mat4 projection;\n"
+  "uniform vec3 light;\n"
+  "uniform int columns;\n"
+  "uniform int rows;\n"
+  "uniform float spacing;\n"
+  "out vec4 lit;\n"
+  "void main(){\n"
+  "  vec4 eye = modelview * vec4(position,1.0);\n"
+  "  vec3 n = normalize(mat3(modelview) * normal);\n"
+  "  float across = float(gl_InstanceID % columns) - 0.5 * float(columns - 1);\n"
+  "  float down = float(gl_InstanceID / columns) - 0.5 * float(rows - 1);\n"
+  "  eye.xy += vec2(across,-down) * spacing;\n"
+  "  lit = vec4(colour.rgb * max(dot(n,light),0.0),colour.a);\n"
+  "  gl_Position = projection * eye;\n"
+  "}\n";
+
+static const char *fragment_source =
+  "#version 140\n"
+  "in vec4 lit;\n"
+  "out vec4 fragment;\n"
+  "void main(){\n"
+  "  fragment = lit;\n"
+  "}\n";
+
+
+/* shaders_supported():
+   description: checks the GL we've got is new enough for the shaders
+   output: true if it is
+ */
+bool shaders_supported(void){
+  const char *version = (const char *) glGetString(GL_VERSION);
+  int major = 0, minor = 0;
+
+  if(version == NULL || sscanf(version,"%d.%d",&major,&minor) != 2)
+    return false;
+
+  return (major > SHADER_GL_MAJOR ||
+          (major == SHADER_GL_MAJOR && minor >= SHADER_GL_MINOR)) ?
+    true : false;
+}
+
+
+/* compile():
+   description: compiles one of the shaders, printing why if it can't
+   inputs: the type of shader, its source
+   output: the shader, or 0 if it didn't compile
+ */
+static GLuint compile(GLenum type, const char *source){
+  GLuint s = glCreateShader(type);
+  GLint ok, length;
+  char *log;
+
+  glShaderSource(s,1,&source,NULL);
+  glCompileShader(s);
+  glGetShaderiv(s,GL_COMPILE_STATUS,&ok);
+  if(ok) return s;
+
+  glGetShaderiv(s,GL_INFO_LOG_LENGTH,&length);
+  if((log = (char *) malloc(length + 1)) != NULL) {
+    glGetShaderInfoLog(s,length,NULL,log);
+    log[length] = '\0';
+    fprintf(stderr,"%s",log);
+    free(log);
+  }
+
+  glDeleteShader(s);
+  return 0;
+}
+
+
+/* build_shader():
+   description: compiles and links the lighting program, binding the
+                vertex inputs to the SHADER_ attribute numbers
+   inputs: the shader to fill in
+   output: false if it wouldn't compile or link
+ */
+bool build_shader(shader *s){
+  GLuint vs, fs;
+  GLint ok;
+
+  vs = compile(GL_VERTEX_SHADER,vertex_source);
+  fs = compile(GL_FRAGMENT_SHADER,fragment_source);
+  if(vs == 0 || fs == 0) return false;
+
+  s->program = glCreateProgram();
+  glAttachShader(s->program,vs);
+  glAttachShader(s->program,fs);
+  glBindAttribLocation(s->program,SHADER_POSITION,"position");
+  glBindAttribLocation(s->program,SHADER_NORMAL,"normal");
+  glBindAttribLocation(s->program,SHADER_COLOUR,"colour");
+  glBindFragDataLocation(s->program,0,"fragment");
+  glLinkProgram(s->program);
+
+  /* the program keeps them */
+  glDeleteShader(vs);
+  glDeleteShader(fs);
+
+  glGetProgramiv(s->program,GL_LINK_STATUS,&ok);
+  if(!ok) return false;
+
+  s->modelview = glGetUniformLocation(s->program,"modelview");
+  s->projection = glGetUniformLocation(s->program,"projection");
+  s->light = glGetUniformLocation(s->program,"light");
+  s->columns = glGetUniformLocation(s->program,"columns");
+  s->rows = glGetUniformLocation(s->program,"rows");
+  s->spacing = glGetUniformLocation(s->program,"spacing");
+
+  return true;
+}
+
+#else
+
+/* shaders_supported():
+   description: the shaders can't be built on OS X
+ */
+bool shaders_supported(void){
+  return false;
+}
+
+
+/* build_shader():
+   description: the shaders can't be built on OS X
+ */
+bool build_shader(shader *s){
+  return false;
+}
+
+#endif
@@ -0,0 +1,37 @@
+/********************
+ * FILE: shader.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for shader.c. Defines where the shader's inputs are and
+ *     contains the prototypes for the interface functions
+ */
+
+#ifndef _CB_SHADER_H
+#define _CB_SHADER_H
+
+#include "common.h"
+#include "platform.h"
+
+/* the attribute numbers the vertex arrays are bound to */
+#define SHADER_POSITION 0
+#define SHADER_NORMAL 1
+#define SHADER_COLOUR 2
+
+/* the lighting program and where its uniforms are */
+typedef struct shader_t {
+  GLuint program;
+
+  GLint modelview;
+  GLint projection;
+  GLint light;
+  GLint columns;
+  GLint rows;
+  GLint spacing;
+} shader;
+
+/* interface function prototypes */
+bool shaders_supported(void);
+bool build_shader(shader *);
+#endif /* !_CB_SHADER_H */
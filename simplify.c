@@ -0,0 +1,582 @@
+/********************
+ * FILE: simplify.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Functions for making simpler versions of an object, for drawing when
+ *     it's too small on the screen for all its triangles to matter. Edges
+ *     are collapsed one at a time, cheapest first, with the cost measured
+ *     by quadric error metrics (Garland & Heckbert). Each collapse moves one
+ *     end of the edge onto the other, so no new vertices are needed and all
+ *     the levels can share the object's vertex array. Edges on the border
+ *     of the model, or between faces of different colours, are expensive to
+ *     move so the outline and colours survive.
+ */
+
+#include <stdlib.h> /*for malloc*/
+#include <string.h> /*for memset*/
+#include <math.h> /*for sqrt*/
+
+#include "common.h"
+#include "arena.h"
+#include "face.h"
+#include "vertex.h"
+#include "object.h"
+#include "simplify.h"
+
+/* how much more it costs to move an edge on a border than across a flat
+   surface */
+#define BORDER_WEIGHT 1000.0
+
+/* a collapse that turns a triangle further than this (the cosine of the
+   angle) isn't allowed */
+#define MAX_FLIP 0.2
+
+/* the error for a vertex moved to a point is v' Q v, with Q symmetric so
+   only 10 numbers are needed: aa ab ac ad bb bc bd cc cd dd */
+typedef struct {
+  double q[10];
+} quadric;
+
+/* a possible collapse, moving u onto v. it's out of date if either vertex
+   has changed since it was worked out */
+typedef struct {
+  double cost;
+  int u, v;
+  int u_version, v_version;
+} collapse;
+
+/* the triangles using a vertex */
+typedef struct {
+  int *tris;
+  int n, size;
+} tri_list;
+
+/* everything about the model being simplified */
+typedef struct {
+  object *o;
+
+  /* the triangles, the face each came from and if it's still there */
+  int *tris;
+  int *tri_face;
+  char *tri_alive;
+  int n_tris;
+  int live;
+
+  /* per vertex */
+  quadric *quadrics;
+  tri_list *vertex_tris;
+  int *version;
+  char *alive;
+  int *mark;
+  int tick;
+
+  /* the collapses, cheapest at the top */
+  collapse *heap;
+  int n_heap, heap_size;
+} mesh;
+
+
+/* add_plane():
+   description: adds the error for moving away from a plane to a quadric
+   inputs: the quadric, the plane (ax + by + cz + d = 0) and its weight
+ */
+static void add_plane(quadric *q, double a, double b, double c, double d,
+                      double w){
+  q->q[0] += w * a * a; q->q[1] += w * a * b; q->q[2] += w * a * c;
+  q->q[3] += w * a * d; q->q[4] += w * b * b; q->q[5] += w * b * c;
+  q->q[6] += w * b * d; q->q[7] += w * c * c; q->q[8] += w * c * d;
+  q->q[9] += w * d * d;
+}
+
+
+/* quadric_error():
+   description: the error for moving the vertices of two quadrics to v
+ */
+static double quadric_error(quadric *a, quadric *b, vertex *v){
+  double q[10], x = v->x, y = v->y, z = v->z, e;
+  int i;
+
+  for(i = 0; i < 10; i++)
+    q[i] = a->q[i] + b->q[i];
+
+  e = q[0] * x * x + 2 * q[1] * x * y + 2 * q[2] * x * z + 2 * q[3] * x +
+      q[4] * y * y + 2 * q[5] * y * z + 2 * q[6] * y +
+      q[7] * z * z + 2 * q[8] * z + q[9];
+
+  return e < 0 ? 0 : e;
+}
+
+
+/* cross():
+   description: the (unnormalised) normal of the triangle abc
+ */
+static void cross(vertex *a, vertex *b, vertex *c, double *n){
+  double u[3], v[3];
+
+  u[0] = b->x - a->x; u[1] = b->y - a->y; u[2] = b->z - a->z;
+  v[0] = c->x - a->x; v[1] = c->y - a->y; v[2] = c->z - a->z;
+
+  n[0] = u[1] * v[2] - u[2] * v[1];
+  n[1] = u[2] * v[0] - u[0] * v[2];
+  n[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+
+/* add_tri():
+   description: adds a triangle to a vertex's list
+   output: false if there wasn't enough memory
+ */
+static bool add_tri(tri_list *l, int t){
+  int *tris;
+
+  if(l->n == l->size) {
+    l->size = l->size ? 2 * l->size : 8;
+    if((tris = (int *) realloc(l->tris,sizeof(int) * l->size)) == NULL)
+      return false;
+    l->tris = tris;
+  }
+
+  l->tris[l->n++] = t;
+  return true;
+}
+
+
+/* push():
+   description: adds the collapse of u onto v to the heap
+   output: false if there wasn't enough memory
+ */
+static bool push(mesh *m, int u, int v){
+  collapse c, *heap;
+  int i;
+
+  if(m->n_heap == m->heap_size) {
+    m->heap_size *= 2;
+    heap = (collapse *) realloc(m->heap,sizeof(collapse) * m->heap_size);
+    if(heap == NULL) return false;
+    m->heap = heap;
+  }
+
+  c.cost = quadric_error(m->quadrics + u,m->quadrics + v,
+                         m->o->vertices + v);
+  c.u = u;
+  c.v = v;
+  c.u_version = m->version[u];
+  c.v_version = m->version[v];
+
+  for(i = m->n_heap++; i > 0 && m->heap[(i - 1) / 2].cost > c.cost;
+      i = (i - 1) / 2)
+    m->heap[i] = m->heap[(i - 1) / 2];
+  m->heap[i] = c;
+
+  return true;
+}
+
+
+/* pop():
+   description: takes the cheapest collapse off the heap
+ */
+static collapse pop(mesh *m){
+  collapse top = m->heap[0], last = m->heap[--m->n_heap];
+  int i = 0, child;
+
+  while((child = 2 * i + 1) < m->n_heap){
+    if(child + 1 < m->n_heap && m->heap[child + 1].cost < m->heap[child].cost)
+      child++;
+    if(m->heap[child].cost >= last.cost) break;
+    m->heap[i] = m->heap[child];
+    i = child;
+  }
+  m->heap[i] = last;
+
+  return top;
+}
+
+
+/* has_vertex():
+   description: true if triangle t uses vertex v
+ */
+static bool has_vertex(mesh *m, int t, int v){
+  int *tri = m->tris + 3 * t;
+  return (tri[0] == v || tri[1] == v || tri[2] == v) ? true : false;
+}
+
+
+/* tidy_list():
+   description: drops the triangles that have gone from a vertex's list
+ */
+static void tidy_list(mesh *m, tri_list *l){
+  int i, n = 0;
+
+  for(i = 0; i < l->n; i++)
+    if(m->tri_alive[l->tris[i]])
+      l->tris[n++] = l->tris[i];
+  l->n = n;
+}
+
+
+/* same_colour():
+   description: true if two faces are the same colour
+ */
+static bool same_colour(face *a, face *b){
+  return (a->colour[0] == b->colour[0] && a->colour[1] == b->colour[1] &&
+          a->colour[2] == b->colour[2]) ? true : false;
+}
+
+
+/* add_borders():
+   description: adds the extra cost of moving the vertices of edges with
+                only one triangle, or with different coloured faces either
+                side. the cost is for moving away from a plane through the
+                edge, at right angles to the triangle
+ */
+static void add_borders(mesh *m){
+  vertex *v = m->o->vertices, *a, *b;
+  double n[3], e[3], p[3], l;
+  int t, i, j, k, other, shared;
+  tri_list *list;
+
+  for(t = 0; t < m->n_tris; t++){
+    if(!m->tri_alive[t]) continue;
+
+    for(i = 0; i < 3; i++){
+      a = v + m->tris[3 * t + i];
+      b = v + m->tris[3 * t + (i + 1) % 3];
+
+      /* look for another triangle on this edge, of the same colour */
+      list = m->vertex_tris + m->tris[3 * t + i];
+      shared = 0;
+      for(j = 0; j < list->n; j++){
+        other = list->tris[j];
+        if(other == t || !has_vertex(m,other,m->tris[3 * t + (i + 1) % 3]))
+          continue;
+        shared++;
+        if(!same_colour(m->o->faces + m->tri_face[other],
+                        m->o->faces + m->tri_face[t]))
+          shared = -1000;
+      }
+      if(shared > 0) continue;
+
+      cross(v + m->tris[3 * t],v + m->tris[3 * t + 1],v + m->tris[3 * t + 2],n);
+      e[0] = b->x - a->x; e[1] = b->y - a->y; e[2] = b->z - a->z;
+      p[0] = e[1] * n[2] - e[2] * n[1];
+      p[1] = e[2] * n[0] - e[0] * n[2];
+      p[2] = e[0] * n[1] - e[1] * n[0];
+      if((l = sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2])) == 0) continue;
+      for(k = 0; k < 3; k++)
+        p[k] /= l;
+
+      l = BORDER_WEIGHT * (e[0] * e[0] + e[1] * e[1] + e[2] * e[2]);
+      add_plane(m->quadrics + m->tris[3 * t + i],p[0],p[1],p[2],
+                -(p[0] * a->x + p[1] * a->y + p[2] * a->z),l);
+      add_plane(m->quadrics + m->tris[3 * t + (i + 1) % 3],p[0],p[1],p[2],
+                -(p[0] * a->x + p[1] * a->y + p[2] * a->z),l);
+    }
+  }
+}
+
+
+/* can_collapse():
+   description: checks moving u onto v won't break the model. they must
+                still share an edge, the only vertices next to both must be
+                the ones on the triangles along that edge (or the surface
+                would fold onto itself), and no triangle can flip over
+ */
+static bool can_collapse(mesh *m, int u, int v){
+  tri_list *lu = m->vertex_tris + u, *lv = m->vertex_tris + v;
+  vertex *p = m->o->vertices, *corner[3];
+  int i, j, k, t, w, shared = 0, common = 0;
+  double before[3], after[3], dot, len_before, len_after;
+
+  m->tick++;
+  for(i = 0; i < lu->n; i++){
+    t = lu->tris[i];
+    if(!m->tri_alive[t]) continue;
+    if(has_vertex(m,t,v)) shared++;
+    for(j = 0; j < 3; j++)
+      m->mark[m->tris[3 * t + j]] = m->tick;
+  }
+  if(shared == 0) return false;
+
+  m->tick++;
+  for(i = 0; i < lv->n; i++){
+    t = lv->tris[i];
+    if(!m->tri_alive[t]) continue;
+    for(j = 0; j < 3; j++){
+      w = m->tris[3 * t + j];
+      if(w != u && w != v && m->mark[w] == m->tick - 1) {
+        m->mark[w] = m->tick;
+        common++;
+      }
+    }
+  }
+  if(common != shared) return false;
+
+  for(i = 0; i < lu->n; i++){
+    t = lu->tris[i];
+    if(!m->tri_alive[t] || has_vertex(m,t,v)) continue;
+
+    for(k = 0; k < 3; k++)
+      corner[k] = p + m->tris[3 * t + k];
+    cross(corner[0],corner[1],corner[2],before);
+    for(k = 0; k < 3; k++)
+      if(m->tris[3 * t + k] == u)
+        corner[k] = p + v;
+    cross(corner[0],corner[1],corner[2],after);
+
+    /* a triangle with no area can't flip, but one can't be made */
+    dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+    len_before = sqrt(before[0] * before[0] + before[1] * before[1] +
+                      before[2] * before[2]);
+    len_after = sqrt(after[0] * after[0] + after[1] * after[1] +
+                     after[2] * after[2]);
+    if(len_after == 0 ||
+       (len_before > 0 && dot < MAX_FLIP * len_before * len_after))
+      return false;
+  }
+
+  return true;
+}
+
+
+/* do_collapse():
+   description: moves u onto v. the triangles along the edge go, the rest
+                of u's triangles are given to v, and the collapses around v
+                are worked out again
+   output: false if there wasn't enough memory
+ */
+static bool do_collapse(mesh *m, int u, int v){
+  tri_list *lu = m->vertex_tris + u, *lv = m->vertex_tris + v;
+  int i, j, t, w;
+
+  for(i = 0; i < lu->n; i++){
+    t = lu->tris[i];
+    if(!m->tri_alive[t]) continue;
+
+    if(has_vertex(m,t,v)) {
+      m->tri_alive[t] = false;
+      m->live--;
+      continue;
+    }
+
+    for(j = 0; j < 3; j++)
+      if(m->tris[3 * t + j] == u)
+        m->tris[3 * t + j] = v;
+    if(add_tri(lv,t) == false) return false;
+  }
+
+  for(i = 0; i < 10; i++)
+    m->quadrics[v].q[i] += m->quadrics[u].q[i];
+
+  m->alive[u] = false;
+  lu->n = 0;
+  m->version[v]++;
+  tidy_list(m,lv);
+
+  /* the cost of every collapse to or from v has changed */
+  m->tick++;
+  for(i = 0; i < lv->n; i++){
+    t = lv->tris[i];
+    for(j = 0; j < 3; j++){
+      w = m->tris[3 * t + j];
+      if(w == v || m->mark[w] == m->tick) continue;
+      m->mark[w] = m->tick;
+      if(push(m,v,w) == false || push(m,w,v) == false) return false;
+    }
+  }
+
+  return true;
+}
+
+
+/* save_level():
+   description: copies the triangles left into a level of detail, grouped
+                by the face they came from so they keep its colour
+   output: false if there wasn't enough memory
+ */
+static bool save_level(mesh *m, lod *l){
+  object *o = m->o;
+  int *count, i, t, f, n = 0;
+  face *face_out;
+
+  if((count = (int *) calloc(o->n_faces,sizeof(int))) == NULL) return false;
+
+  for(t = 0; t < m->n_tris; t++)
+    if(m->tri_alive[t])
+      count[m->tri_face[t]]++;
+
+  for(f = 0, l->n_faces = 0; f < o->n_faces; f++)
+    if(count[f] > 0)
+      l->n_faces++;
+
+  l->n_indices = 3 * m->live;
+  l->faces = alloc_face_array(o->mem,l->n_faces);
+  l->indices = (int *) arena_alloc(o->mem,sizeof(int) * (size_t) l->n_indices);
+  if(l->faces == NULL || l->indices == NULL) {
+    free(count);
+    return false;
+  }
+
+  /* lay the faces out, then use count to keep track of where each one is
+     filled up to */
+  for(f = 0, i = 0; f < o->n_faces; f++){
+    if(count[f] == 0) continue;
+
+    face_out = l->faces + i++;
+    *face_out = o->faces[f];
+    init_face(face_out,3 * count[f]);
+    face_out->draw_mode = GL_TRIANGLES;
+    face_out->first_index = n;
+    count[f] = n;
+    n += face_out->n_vertices;
+  }
+
+  for(t = 0; t < m->n_tris; t++)
+    if(m->tri_alive[t]) {
+      memcpy(l->indices + count[m->tri_face[t]],m->tris + 3 * t,
+             sizeof(int) * 3);
+      count[m->tri_face[t]] += 3;
+    }
+
+  free(count);
+  return true;
+}
+
+
+/* build_lods():
+   description: makes the levels of detail for an object, with LOD_LEVELS of
+     its triangles. only GL_TRIANGLES faces are used, so the object should be
+     triangulated first. if the model can't be simplified that far the last
+     levels have as few triangles as could be managed. the levels come from
+     the object's arena
+   inputs: an alloced object that has been filled with all the data
+   output: false if there wasn't enough memory
+ */
+bool build_lods(object *o){
+  float levels[N_LOD_LEVELS] = LOD_LEVELS;
+  int i, j, t, f, *indices, level = 0, target, start;
+  double n[3], len;
+  bool ok = false;
+  vertex *v;
+  collapse c;
+  mesh m;
+
+  if(o == NULL) return false;
+
+  memset(&m,0,sizeof(mesh));
+  m.o = o;
+
+  for(f = 0; f < o->n_faces; f++)
+    if(o->faces[f].draw_mode == GL_TRIANGLES)
+      m.n_tris += o->faces[f].n_vertices / 3;
+
+  m.tris = (int *) malloc(sizeof(int) * 3 * (m.n_tris + 1));
+  m.tri_face = (int *) malloc(sizeof(int) * (m.n_tris + 1));
+  m.tri_alive = (char *) malloc(m.n_tris + 1);
+  m.quadrics = (quadric *) calloc(o->n_vertices + 1,sizeof(quadric));
+  m.vertex_tris = (tri_list *) calloc(o->n_vertices + 1,sizeof(tri_list));
+  m.version = (int *) calloc(o->n_vertices + 1,sizeof(int));
+  m.alive = (char *) malloc(o->n_vertices + 1);
+  m.mark = (int *) calloc(o->n_vertices + 1,sizeof(int));
+  m.heap_size = 6 * m.n_tris + 16;
+  m.heap = (collapse *) malloc(sizeof(collapse) * m.heap_size);
+  o->lods = (lod *) arena_alloc(o->mem,sizeof(lod) * N_LOD_LEVELS);
+
+  if(m.tris == NULL || m.tri_face == NULL || m.tri_alive == NULL ||
+     m.quadrics == NULL || m.vertex_tris == NULL || m.version == NULL ||
+     m.alive == NULL || m.mark == NULL || m.heap == NULL || o->lods == NULL)
+    goto out;
+
+  memset(m.alive,true,o->n_vertices);
+
+  /* gather up the triangles, leaving out any that are broken */
+  for(f = 0, t = 0; f < o->n_faces; f++){
+    if(o->faces[f].draw_mode != GL_TRIANGLES) continue;
+
+    indices = FACE_INDICES(o,o->faces + f);
+    for(i = 0; i + 2 < o->faces[f].n_vertices; i += 3, t++){
+      memcpy(m.tris + 3 * t,indices + i,sizeof(int) * 3);
+      m.tri_face[t] = f;
+      m.tri_alive[t] = true;
+
+      for(j = 0; j < 3; j++)
+        if(indices[i + j] < 0 || indices[i + j] >= o->n_vertices)
+          m.tri_alive[t] = false;
+      if(m.tri_alive[t] && (indices[i] == indices[i + 1] ||
+         indices[i + 1] == indices[i + 2] || indices[i + 2] == indices[i]))
+        m.tri_alive[t] = false;
+
+      if(!m.tri_alive[t]) continue;
+      m.live++;
+
+      for(j = 0; j < 3; j++)
+        if(add_tri(m.vertex_tris + indices[i + j],t) == false)
+          goto out;
+    }
+  }
+
+  /* each vertex starts with the planes of its triangles, weighted by area */
+  for(t = 0; t < m.n_tris; t++){
+    if(!m.tri_alive[t]) continue;
+
+    v = o->vertices + m.tris[3 * t];
+    cross(v,o->vertices + m.tris[3 * t + 1],o->vertices + m.tris[3 * t + 2],n);
+    if((len = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2])) == 0) continue;
+
+    for(j = 0; j < 3; j++)
+      add_plane(m.quadrics + m.tris[3 * t + j],n[0] / len,n[1] / len,
+                n[2] / len,-(n[0] * v->x + n[1] * v->y + n[2] * v->z) / len,
+                len * 0.5);
+  }
+
+  add_borders(&m);
+
+  for(t = 0; t < m.n_tris; t++){
+    if(!m.tri_alive[t]) continue;
+    for(j = 0; j < 3; j++)
+      if(push(&m,m.tris[3 * t + j],m.tris[3 * t + (j + 1) % 3]) == false ||
+         push(&m,m.tris[3 * t + (j + 1) % 3],m.tris[3 * t + j]) == false)
+        goto out;
+  }
+
+  /* collapse the cheapest edge until there are few enough triangles for
+     each level in turn */
+  start = m.live;
+  target = (int) (levels[0] * start);
+  while(level < N_LOD_LEVELS){
+    if(m.live <= target || m.n_heap == 0) {
+      if(save_level(&m,o->lods + level) == false) goto out;
+      if(++level < N_LOD_LEVELS)
+        target = (int) (levels[level] * start);
+      continue;
+    }
+
+    c = pop(&m);
+    if(!m.alive[c.u] || !m.alive[c.v] || c.u_version != m.version[c.u] ||
+       c.v_version != m.version[c.v] || !can_collapse(&m,c.u,c.v))
+      continue;
+
+    if(do_collapse(&m,c.u,c.v) == false) goto out;
+  }
+
+  o->n_lods = N_LOD_LEVELS;
+  ok = true;
+
+out:
+  if(m.vertex_tris != NULL)
+    for(i = 0; i < o->n_vertices; i++)
+      free(m.vertex_tris[i].tris);
+
+  free(m.tris);
+  free(m.tri_face);
+  free(m.tri_alive);
+  free(m.quadrics);
+  free(m.vertex_tris);
+  free(m.version);
+  free(m.alive);
+  free(m.mark);
+  free(m.heap);
+
+  return ok;
+}
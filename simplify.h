@@ -0,0 +1,22 @@
+/********************
+ * FILE: simplify.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for simplify.c. Contains the prototypes for the interface
+ *     functions
+ */
+
+#ifndef _CB_SIMPLIFY_H
+#define _CB_SIMPLIFY_H
+
+#include "common.h"
+
+/* the fraction of the triangles kept at each level of detail */
+#define LOD_LEVELS { 0.5f, 0.25f, 0.1f }
+#define N_LOD_LEVELS 3
+
+/* interface function prototypes */
+bool build_lods(object *);
+#endif /* !_CB_SIMPLIFY_H */
@@ -0,0 +1,274 @@
+/********************
+ * FILE: strip.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Functions for turning GL_TRIANGLES faces into triangle strips. Strips
+ *     are grown greedily across shared edges, then joined together with
+ *     degenerate triangles so each face is still drawn with one call. A strip
+ *     needs about one index per triangle rather than three.
+ */
+
+#include <stdlib.h> /*for malloc, qsort*/
+#include <string.h> /*for memcpy*/
+
+#include "common.h"
+#include "arena.h"
+#include "face.h"
+#include "vertex.h"
+#include "object.h"
+#include "strip.h"
+
+/* an edge of a triangle, for finding the triangle on the other side */
+typedef struct {
+  int lo, hi;
+  int tri;
+  int edge;
+} half_edge;
+
+/* scratch space for stripping one face */
+typedef struct {
+  /* the triangle across each edge of each triangle, or -1 */
+  int *across;
+  half_edge *edges;
+  char *used;
+  int *strip;
+} stripper;
+
+
+/* compare_edges():
+   description: qsort() comparison, puts the same edges next to each other
+ */
+static int compare_edges(const void *a, const void *b){
+  const half_edge *x = (const half_edge *) a, *y = (const half_edge *) b;
+
+  if(x->lo != y->lo) return x->lo < y->lo ? -1 : 1;
+  if(x->hi != y->hi) return x->hi < y->hi ? -1 : 1;
+  return 0;
+}
+
+
+/* find_neighbours():
+   description: finds the triangle on the other side of each edge. edges
+                with more than two triangles on them don't count
+   inputs: the face's indices, the number of triangles, the scratch space
+ */
+static void find_neighbours(int *indices, int n_tris, stripper *s){
+  int i, j, a, b;
+
+  for(i = 0; i < n_tris; i++)
+    for(j = 0; j < 3; j++){
+      a = indices[3 * i + j];
+      b = indices[3 * i + (j + 1) % 3];
+      s->edges[3 * i + j].lo = a < b ? a : b;
+      s->edges[3 * i + j].hi = a < b ? b : a;
+      s->edges[3 * i + j].tri = i;
+      s->edges[3 * i + j].edge = j;
+      s->across[3 * i + j] = -1;
+    }
+
+  qsort(s->edges,3 * n_tris,sizeof(half_edge),compare_edges);
+
+  for(i = 0; i < 3 * n_tris; i = j){
+    for(j = i + 1; j < 3 * n_tris && compare_edges(s->edges + i,
+                                                   s->edges + j) == 0; j++);
+
+    if(j - i == 2) {
+      s->across[3 * s->edges[i].tri + s->edges[i].edge] = s->edges[i + 1].tri;
+      s->across[3 * s->edges[i + 1].tri + s->edges[i + 1].edge] =
+        s->edges[i].tri;
+    }
+  }
+}
+
+
+/* next_triangle():
+   description: finds the unused triangle across the last edge of a strip,
+                and the vertex it adds. the triangle has to go round the
+                same way as the strip would draw it
+   inputs: the face's indices, the scratch space, the strip and its length,
+           the last triangle in the strip
+   output: the triangle, or -1 if there isn't one. *vertex is set to the
+           new vertex
+ */
+static int next_triangle(int *indices, stripper *s, int *strip, int n,
+                         int from, int *vertex){
+  int a = strip[n - 2], b = strip[n - 1], j, t, *tri;
+
+  /* the triangle the strip adds is a,b,new when n is even and b,a,new when
+     it's odd. look for b then a in the neighbour, swapping them first if
+     need be */
+  if(n % 2 == 0) {
+    j = a;
+    a = b;
+    b = j;
+  }
+
+  for(j = 0; j < 3; j++){
+    t = s->across[3 * from + j];
+    if(t < 0 || s->used[t]) continue;
+
+    tri = indices + 3 * t;
+    if(tri[0] == b && tri[1] == a) *vertex = tri[2];
+    else if(tri[1] == b && tri[2] == a) *vertex = tri[0];
+    else if(tri[2] == b && tri[0] == a) *vertex = tri[1];
+    else continue;
+
+    return t;
+  }
+
+  return -1;
+}
+
+
+/* grow_strip():
+   description: starts a strip at a triangle, turned so it carries on over
+                an edge with an unused triangle on the other side if it can,
+                then keeps going for as long as there's a triangle to add
+   inputs: the face's indices, the scratch space, the first triangle
+   output: the number of indices in the strip, which is in s->strip
+ */
+static int grow_strip(int *indices, stripper *s, int start){
+  int *tri = indices + 3 * start, n, j, t = -1, v, last = start;
+
+  s->used[start] = true;
+
+  for(j = 0; j < 3; j++){
+    s->strip[0] = tri[j];
+    s->strip[1] = tri[(j + 1) % 3];
+    s->strip[2] = tri[(j + 2) % 3];
+    if((t = next_triangle(indices,s,s->strip,3,start,&v)) >= 0)
+      break;
+  }
+
+  /* on its own, so leave it the way it was */
+  if(t < 0)
+    memcpy(s->strip,tri,sizeof(int) * 3);
+
+  for(n = 3; t >= 0; n++){
+    s->strip[n] = v;
+    s->used[t] = true;
+    last = t;
+    t = next_triangle(indices,s,s->strip,n + 1,last,&v);
+  }
+
+  return n;
+}
+
+
+/* strip_face():
+   description: turns a GL_TRIANGLES face into one triangle strip. the
+                strips found are joined by repeating the last index of one
+                and the first of the next (and the first again if need be,
+                so the next strip starts on an even triangle)
+   inputs: the object, the face, the scratch space, where to put the indices
+           and their offset in the new index buffer, the stats to add to
+   output: the number of indices written
+ */
+static int strip_face(object *o, face *f, stripper *s, int *out, int first,
+                      strip_stats *stats){
+  int *indices = FACE_INDICES(o,f);
+  int n_tris = f->n_vertices / 3, n_out = 0, i, n;
+
+  find_neighbours(indices,n_tris,s);
+  memset(s->used,0,n_tris);
+
+  for(i = 0; i < n_tris; i++){
+    if(s->used[i]) continue;
+
+    n = grow_strip(indices,s,i);
+
+    if(n_out > 0) {
+      out[n_out] = out[n_out - 1];
+      out[n_out + 1] = s->strip[0];
+      n_out += 2;
+      if(n_out % 2 == 1)
+        out[n_out++] = s->strip[0];
+    }
+
+    memcpy(out + n_out,s->strip,sizeof(int) * n);
+    n_out += n;
+
+    stats->n_strips++;
+    if(n - 2 > stats->longest)
+      stats->longest = n - 2;
+  }
+
+  f->draw_mode = GL_TRIANGLE_STRIP;
+  f->first_index = first;
+  f->n_vertices = n_out;
+
+  return n_out;
+}
+
+
+/* stripify():
+   description: turns every GL_TRIANGLES face of the object into a triangle
+     strip. other faces are left alone. works best once the object has been
+     triangulated and merged. the new index buffer comes from the object's
+     arena, the old one stays there until the object is freed
+   inputs: an alloced object that has been filled with all the data, the
+           stats to fill in
+   output: false if there wasn't enough memory
+ */
+bool stripify(object *o, strip_stats *stats){
+  int *new_indices, i, n = 0, largest = 0, bound = 0;
+  bool ok = true;
+  stripper s;
+  face *f;
+
+  memset(stats,0,sizeof(strip_stats));
+  if(o == NULL) return false;
+
+  stats->indices_before = o->n_indices;
+
+  /* each triangle takes at most 3 indices, and 3 more to join it on */
+  for(i = 0; i < o->n_faces; i++){
+    f = o->faces + i;
+    if(f->draw_mode == GL_TRIANGLES) {
+      stats->n_triangles += f->n_vertices / 3;
+      bound += 2 * f->n_vertices;
+      if(f->n_vertices > largest)
+        largest = f->n_vertices;
+    } else
+      bound += f->n_vertices;
+  }
+
+  s.across = (int *) malloc(sizeof(int) * largest);
+  s.edges = (half_edge *) malloc(sizeof(half_edge) * largest);
+  s.used = (char *) malloc(largest / 3 + 1);
+  s.strip = (int *) malloc(sizeof(int) * (largest / 3 + 2));
+  new_indices = (int *) arena_alloc(o->mem,sizeof(int) * (size_t) bound);
+
+  if(s.across == NULL || s.edges == NULL || s.used == NULL ||
+     s.strip == NULL || new_indices == NULL) {
+    ok = false;
+    goto out;
+  }
+
+  for(i = 0; i < o->n_faces; i++){
+    f = o->faces + i;
+
+    if(f->draw_mode == GL_TRIANGLES && f->n_vertices >= 3) {
+      n += strip_face(o,f,&s,new_indices + n,n,stats);
+    } else {
+      memcpy(new_indices + n,FACE_INDICES(o,f),sizeof(int) * f->n_vertices);
+      f->first_index = n;
+      n += f->n_vertices;
+    }
+  }
+
+  o->indices = new_indices;
+  o->n_indices = n;
+  o->index_capacity = bound;
+  stats->indices_after = n;
+
+out:
+  free(s.across);
+  free(s.edges);
+  free(s.used);
+  free(s.strip);
+
+  return ok;
+}
@@ -0,0 +1,27 @@
+/********************
+ * FILE: strip.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for strip.c. Defines the strip statistics structure and
+ *     contains the prototypes for the interface functions
+ */
+
+#ifndef _CB_STRIP_H
+#define _CB_STRIP_H
+
+#include "common.h"
+
+/* what stripify() did, for printing */
+typedef struct {
+  int n_triangles;
+  int n_strips;
+  int longest;
+  int indices_before;
+  int indices_after;
+} strip_stats;
+
+/* interface function prototypes */
+bool stripify(object *,strip_stats *);
+#endif /* !_CB_STRIP_H */
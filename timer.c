@@ -8,6 +8,7 @@
  */
 
 #include <sys/time.h>
+#include <time.h>
 #include <sys/resource.h>
 #include <unistd.h>
 #include <stdio.h>
@@ -91,3 +92,16 @@ void print_timer(void){
 
   printf("timer: secs=%ld usecs=%ld\n",(long int)temp.tv_sec,(long int)temp.tv_usec);
 }
+
+
+/* get_seconds():
+   description: a wall clock time in seconds, for timing how long things
+                take. only useful for taking the difference of two calls
+ */
+double get_seconds(void){
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC,&now);
+
+  return now.tv_sec + now.tv_nsec / 1000000000.0;
+}
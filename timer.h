@@ -16,5 +16,6 @@ void restart_timer(void);
 void stop_timer(void);
 struct timeval get_timer(void);
 void print_timer(void);
+double get_seconds(void);
 
 #endif /* !_CB_TIMER_H */
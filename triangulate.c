@@ -0,0 +1,221 @@
+/********************
+ * FILE: triangulate.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Functions for turning every face of an object into triangles, so the
+ *     whole model can be drawn as GL_TRIANGLES and batched together. Quads
+ *     and polygons are split by ear clipping, which copes with concave faces
+ *     as long as they're (roughly) flat.
+ */
+
+#include <stdlib.h> /*for malloc*/
+#include <string.h> /*for memcpy*/
+#include <math.h> /*for fabs*/
+
+#include "common.h"
+#include "arena.h"
+#include "face.h"
+#include "vertex.h"
+#include "object.h"
+#include "triangulate.h"
+
+/* scratch space for clipping one polygon, big enough for the largest */
+typedef struct {
+  float *u, *v;
+  int *prev, *next;
+} polygon;
+
+
+/* project_face():
+   description: flattens a face onto whichever of the xy, yz or zx planes it
+                is most nearly parallel to, turned so it goes anticlockwise.
+                the face's normal is found with Newell's method, so it's
+                fine for faces that aren't quite flat or are concave
+   inputs: the object, the face, scratch space to put the 2D points in
+ */
+static void project_face(object *o, face *f, polygon *p){
+  int *indices = FACE_INDICES(o,f);
+  vertex *a, *b;
+  double nx = 0, ny = 0, nz = 0, flip;
+  int i;
+
+  for(i = 0; i < f->n_vertices; i++){
+    a = o->vertices + indices[i];
+    b = o->vertices + indices[(i + 1) % f->n_vertices];
+    nx += (a->y - b->y) * (a->z + b->z);
+    ny += (a->z - b->z) * (a->x + b->x);
+    nz += (a->x - b->x) * (a->y + b->y);
+  }
+
+  for(i = 0; i < f->n_vertices; i++){
+    a = o->vertices + indices[i];
+
+    /* drop the biggest part of the normal */
+    if(fabs(nx) >= fabs(ny) && fabs(nx) >= fabs(nz)) {
+      flip = nx;
+      p->u[i] = a->y;
+      p->v[i] = a->z;
+    } else if(fabs(ny) >= fabs(nz)) {
+      flip = ny;
+      p->u[i] = a->z;
+      p->v[i] = a->x;
+    } else {
+      flip = nz;
+      p->u[i] = a->x;
+      p->v[i] = a->y;
+    }
+
+    if(flip < 0)
+      p->v[i] = -p->v[i];
+  }
+}
+
+
+/* cross():
+   description: twice the signed area of the triangle abc, positive when it
+                goes anticlockwise
+ */
+static float cross(polygon *p, int a, int b, int c){
+  return (p->u[b] - p->u[a]) * (p->v[c] - p->v[a]) -
+         (p->v[b] - p->v[a]) * (p->u[c] - p->u[a]);
+}
+
+
+/* is_ear():
+   description: checks if the corner at b can be cut off the polygon. it has
+                to be convex, and no other corner can be inside the triangle
+   inputs: the polygon, the corner and its neighbours
+   output: true if it's an ear
+ */
+static bool is_ear(polygon *p, int a, int b, int c){
+  int i;
+
+  if(cross(p,a,b,c) <= 0) return false;
+
+  for(i = p->next[c]; i != a; i = p->next[i]){
+    if(cross(p,a,b,i) >= 0 && cross(p,b,c,i) >= 0 && cross(p,c,a,i) >= 0)
+      return false;
+  }
+
+  return true;
+}
+
+
+/* clip_face():
+   description: splits one face into n_vertices - 2 triangles by cutting ears
+                off it until there's only one triangle left. the triangles
+                keep the face's winding, so culling still works.
+                if no ear can be found (the face twists over itself) the
+                next corner is cut anyway, so we always finish
+   inputs: the object, the face, the scratch space, where the new faces and
+           their indices go, and where those indices will start in the
+           index buffer
+ */
+static void clip_face(object *o, face *f, polygon *p, face *out,
+                      int *indices, int first){
+  int *old = FACE_INDICES(o,f);
+  int left = f->n_vertices, i, misses = 0;
+
+  project_face(o,f,p);
+
+  for(i = 0; i < left; i++){
+    p->prev[i] = (i + left - 1) % left;
+    p->next[i] = (i + 1) % left;
+  }
+
+  for(i = 0; left > 2; ){
+    if(misses < left && !is_ear(p,p->prev[i],i,p->next[i])) {
+      i = p->next[i];
+      misses++;
+      continue;
+    }
+
+    *out = *f;
+    init_face(out,3);
+    out->first_index = first;
+    *indices++ = old[p->prev[i]];
+    *indices++ = old[i];
+    *indices++ = old[p->next[i]];
+    out++;
+    first += 3;
+
+    /* cut the corner off */
+    p->next[p->prev[i]] = p->next[i];
+    p->prev[p->next[i]] = p->prev[i];
+    i = p->prev[i];
+    left--;
+    misses = 0;
+  }
+}
+
+
+/* triangulate():
+   description: replaces every face of the object with triangles. triangles
+     are left alone, and faces with fewer than 3 vertices (which never draw
+     anything) are dropped. the new faces and indices come from the object's
+     arena, the old ones stay there until the object is freed
+   inputs: an alloced object that has been filled with all the data
+   output: the number of faces the object now has
+ */
+int triangulate(object *o){
+  face *new_faces, *f, *out;
+  int *new_indices, *indices;
+  int i, n_faces = 0, largest = 0;
+  polygon p;
+
+  if(o == NULL || o->n_faces == 0) return 0;
+
+  for(i = 0; i < o->n_faces; i++){
+    f = o->faces + i;
+    if(f->n_vertices >= 3)
+      n_faces += f->n_vertices - 2;
+    if(f->n_vertices > largest)
+      largest = f->n_vertices;
+  }
+
+  new_faces = alloc_face_array(o->mem,n_faces);
+  new_indices = (int *) arena_alloc(o->mem,sizeof(int) * 3 * (size_t) n_faces);
+  p.u = (float *) malloc(sizeof(float) * largest);
+  p.v = (float *) malloc(sizeof(float) * largest);
+  p.prev = (int *) malloc(sizeof(int) * largest);
+  p.next = (int *) malloc(sizeof(int) * largest);
+
+  if(new_faces == NULL || new_indices == NULL || p.u == NULL ||
+     p.v == NULL || p.prev == NULL || p.next == NULL) {
+    n_faces = o->n_faces;
+    goto out;
+  }
+
+  out = new_faces;
+  indices = new_indices;
+
+  for(i = 0; i < o->n_faces; i++){
+    f = o->faces + i;
+    if(f->n_vertices < 3) continue;
+
+    if(f->n_vertices == 3) {
+      /* already a triangle, so it's copied across as it is */
+      memcpy(indices,FACE_INDICES(o,f),sizeof(int) * 3);
+      *out = *f;
+      out->first_index = indices - new_indices;
+    } else
+      clip_face(o,f,&p,out,indices,indices - new_indices);
+    out += f->n_vertices - 2;
+    indices += 3 * (f->n_vertices - 2);
+  }
+
+  o->faces = new_faces;
+  o->n_faces = o->filled_faces = n_faces;
+  o->indices = new_indices;
+  o->n_indices = o->index_capacity = 3 * n_faces;
+
+out:
+  free(p.u);
+  free(p.v);
+  free(p.prev);
+  free(p.next);
+
+  return n_faces;
+}
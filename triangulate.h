@@ -0,0 +1,18 @@
+/********************
+ * FILE: triangulate.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for triangulate.c. Contains the prototypes for the
+ *     interface functions
+ */
+
+#ifndef _CB_TRIANGULATE_H
+#define _CB_TRIANGULATE_H
+
+#include "common.h"
+
+/* interface function prototypes */
+int triangulate(object *);
+#endif /* !_CB_TRIANGULATE_H */
@@ -0,0 +1,375 @@
+/********************
+ * FILE: vcache.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Functions for making better use of the graphics card's post transform
+ *     vertex cache. The triangles in each GL_TRIANGLES face are put in an
+ *     order that reuses recently transformed vertices (Tom Forsyth's "Linear
+ *     Speed Vertex Cache Optimisation"), then the vertex array is put in the
+ *     order the vertices are first used, so they're fetched in order too.
+ *     The average cache miss ratio (misses per triangle) can be measured
+ *     before and after with a simulated FIFO cache.
+ */
+
+#include <stdlib.h> /*for malloc*/
+#include <string.h> /*for memcpy*/
+#include <math.h> /*for powf*/
+
+#include "common.h"
+#include "arena.h"
+#include "face.h"
+#include "vertex.h"
+#include "object.h"
+#include "vcache.h"
+
+/* the weights from Forsyth's paper */
+#define CACHE_DECAY_POWER 1.5f
+#define LAST_TRI_SCORE 0.75f
+#define VALENCE_BOOST_SCALE 2.0f
+#define VALENCE_BOOST_POWER 0.5f
+
+/* everything we need to know about the vertices and triangles of a face
+   while reordering it. the per vertex arrays are for the whole object, but
+   only the vertices in the current face are looked at */
+typedef struct {
+  /* per vertex: the triangles not drawn yet, where those are in adj, how
+     many have been put there, position in the cache (or -1) and score */
+  int *active;
+  int *first;
+  int *used;
+  int *position;
+  float *score;
+
+  /* the triangles using each vertex */
+  int *adj;
+
+  /* per triangle: its score and if it's been drawn yet */
+  float *tri_score;
+  char *drawn;
+
+  /* the new order of the indices */
+  int *out;
+} reorder;
+
+
+/* vertex_score():
+   description: how keen we are to draw a triangle using this vertex. ones
+                that are in the cache, and ones with few triangles left, are
+                better
+   inputs: the vertex's position in the cache, the triangles left using it
+   output: the score, -1 if there aren't any triangles left
+ */
+static float vertex_score(int position, int active){
+  float s = 0.0f;
+
+  if(active == 0) return -1.0f;
+
+  if(position >= 0 && position < 3)
+    s = LAST_TRI_SCORE;
+  else if(position >= 3)
+    s = powf(1.0f - (position - 3) * (1.0f / (VCACHE_SIZE - 3)),
+             CACHE_DECAY_POWER);
+
+  return s + VALENCE_BOOST_SCALE * powf((float) active,-VALENCE_BOOST_POWER);
+}
+
+
+/* in_range():
+   description: true if all the indices of a face are real vertices
+ */
+static bool in_range(object *o, face *f){
+  int *indices = FACE_INDICES(o,f);
+  int i;
+
+  for(i = 0; i < f->n_vertices; i++)
+    if(indices[i] < 0 || indices[i] >= o->n_vertices)
+      return false;
+
+  return true;
+}
+
+
+/* reorder_face():
+   description: puts the triangles of a GL_TRIANGLES face into a cache
+                friendly order. each step draws the best scoring triangle
+                using a vertex in the cache, or if there aren't any, the
+                next triangle that hasn't been drawn
+   inputs: the object, the face, the scratch space
+ */
+static void reorder_face(object *o, face *f, reorder *r){
+  int *indices = FACE_INDICES(o,f);
+  int n_tris = f->n_vertices / 3;
+  int cache[VCACHE_SIZE + 3], n_cache = 0, list[VCACHE_SIZE + 3], n_list;
+  int i, j, k, t, v, *tri, best = -1, next = 0, sum = 0;
+  float best_score;
+
+  for(i = 0; i < 3 * n_tris; i++){
+    v = indices[i];
+    r->active[v] = r->used[v] = 0;
+    r->first[v] = -1;
+    r->position[v] = -1;
+  }
+
+  /* the triangles using each vertex, one list after the other in adj */
+  for(i = 0; i < 3 * n_tris; i++)
+    r->active[indices[i]]++;
+
+  for(i = 0; i < 3 * n_tris; i++){
+    v = indices[i];
+    if(r->first[v] < 0) {
+      r->first[v] = sum;
+      sum += r->active[v];
+    }
+    r->adj[r->first[v] + r->used[v]++] = i / 3;
+  }
+
+  for(i = 0; i < 3 * n_tris; i++){
+    v = indices[i];
+    r->score[v] = vertex_score(-1,r->active[v]);
+  }
+
+  for(t = 0; t < n_tris; t++){
+    tri = indices + 3 * t;
+    r->tri_score[t] = r->score[tri[0]] + r->score[tri[1]] + r->score[tri[2]];
+    r->drawn[t] = false;
+  }
+
+  for(i = 0; i < n_tris; i++){
+    /* nothing in the cache is any use, carry on from the last place we
+       started afresh */
+    if(best < 0) {
+      while(r->drawn[next])
+        next++;
+      best = next;
+    }
+
+    tri = indices + 3 * best;
+    memcpy(r->out + 3 * i,tri,sizeof(int) * 3);
+    r->drawn[best] = true;
+
+    /* take it out of its vertices' lists */
+    for(j = 0; j < 3; j++){
+      v = tri[j];
+      for(k = r->first[v]; r->adj[k] != best; k++);
+      r->adj[k] = r->adj[r->first[v] + --r->active[v]];
+    }
+
+    /* the triangle's vertices go to the front of the cache, and everything
+       else moves back. the 3 that fall off the end still need rescoring */
+    n_list = 0;
+    for(j = 0; j < 3; j++)
+      list[n_list++] = tri[j];
+    for(j = 0; j < n_cache; j++)
+      if(cache[j] != tri[0] && cache[j] != tri[1] && cache[j] != tri[2])
+        list[n_list++] = cache[j];
+
+    n_cache = 0;
+    for(j = 0; j < n_list; j++){
+      v = list[j];
+      if(j < VCACHE_SIZE) {
+        r->position[v] = j;
+        cache[n_cache++] = v;
+      } else
+        r->position[v] = -1;
+      r->score[v] = vertex_score(r->position[v],r->active[v]);
+    }
+
+    /* rescore the triangles touching anything that moved, and pick the
+       best one in the cache to draw next */
+    best = -1;
+    best_score = -1.0f;
+    for(j = 0; j < n_list; j++){
+      v = list[j];
+      for(k = r->first[v]; k < r->first[v] + r->active[v]; k++){
+        t = r->adj[k];
+        tri = indices + 3 * t;
+        r->tri_score[t] = r->score[tri[0]] + r->score[tri[1]] +
+                          r->score[tri[2]];
+        if(r->position[v] >= 0 && r->tri_score[t] > best_score) {
+          best = t;
+          best_score = r->tri_score[t];
+        }
+      }
+    }
+  }
+
+  memcpy(indices,r->out,sizeof(int) * 3 * n_tris);
+}
+
+
+/* acmr():
+   description: works out the average cache miss ratio of the object, the
+                number of vertices that have to be transformed per triangle
+                drawn, with a FIFO cache of VCACHE_SIZE vertices. only
+                GL_TRIANGLES faces are counted. 0.5 is about the best you
+                can do, 3 is the worst
+   inputs: the object
+   output: the ACMR, or 0 if there are no triangles
+ */
+float acmr(object *o){
+  int *stamp, *indices;
+  int i, j, v, misses = 0, n_tris = 0;
+  face *f;
+
+  if(o == NULL || o->n_vertices == 0) return 0.0f;
+
+  /* the miss count when each vertex was last put in the cache. it's still
+     there if fewer than VCACHE_SIZE misses have happened since */
+  stamp = (int *) malloc(sizeof(int) * o->n_vertices);
+  if(stamp == NULL) return 0.0f;
+
+  for(i = 0; i < o->n_vertices; i++)
+    stamp[i] = -VCACHE_SIZE - 1;
+
+  for(i = 0; i < o->n_faces; i++){
+    f = o->faces + i;
+    if(f->draw_mode != GL_TRIANGLES) continue;
+
+    indices = FACE_INDICES(o,f);
+    for(j = 0; j < f->n_vertices; j++){
+      v = indices[j];
+      if(v < 0 || v >= o->n_vertices) continue;
+
+      if(misses - stamp[v] > VCACHE_SIZE) {
+        stamp[v] = misses;
+        misses++;
+      }
+    }
+
+    n_tris += f->n_vertices / 3;
+  }
+
+  free(stamp);
+
+  return n_tris > 0 ? (float) misses / n_tris : 0.0f;
+}
+
+
+/* reorder_triangles():
+   description: puts the triangles of every GL_TRIANGLES face in a cache
+     friendly order. it only moves triangles around inside a face, so it
+     does the most good after the faces have been triangulated and merged
+   inputs: an alloced object that has been filled with all the data
+   output: false if there wasn't enough memory
+ */
+bool reorder_triangles(object *o){
+  reorder r;
+  int i, largest = 0;
+  bool ok = true;
+  face *f;
+
+  if(o == NULL) return false;
+
+  for(i = 0; i < o->n_faces; i++)
+    if(o->faces[i].draw_mode == GL_TRIANGLES &&
+       o->faces[i].n_vertices > largest)
+      largest = o->faces[i].n_vertices;
+
+  /* nothing with more than one triangle, so nothing to do */
+  if(largest <= 3) return true;
+
+  r.active = (int *) malloc(sizeof(int) * o->n_vertices);
+  r.first = (int *) malloc(sizeof(int) * o->n_vertices);
+  r.used = (int *) malloc(sizeof(int) * o->n_vertices);
+  r.position = (int *) malloc(sizeof(int) * o->n_vertices);
+  r.score = (float *) malloc(sizeof(float) * o->n_vertices);
+  r.adj = (int *) malloc(sizeof(int) * largest);
+  r.tri_score = (float *) malloc(sizeof(float) * (largest / 3));
+  r.drawn = (char *) malloc(largest / 3);
+  r.out = (int *) malloc(sizeof(int) * largest);
+
+  if(r.active == NULL || r.first == NULL || r.used == NULL ||
+     r.position == NULL || r.score == NULL || r.adj == NULL ||
+     r.tri_score == NULL || r.drawn == NULL || r.out == NULL) {
+    ok = false;
+    goto out;
+  }
+
+  for(i = 0; i < o->n_faces; i++){
+    f = o->faces + i;
+    if(f->draw_mode == GL_TRIANGLES && f->n_vertices > 3 && in_range(o,f))
+      reorder_face(o,f,&r);
+  }
+
+out:
+  free(r.active);
+  free(r.first);
+  free(r.used);
+  free(r.position);
+  free(r.score);
+  free(r.adj);
+  free(r.tri_score);
+  free(r.drawn);
+  free(r.out);
+
+  return ok;
+}
+
+
+/* reorder_vertices():
+   description: puts the vertex array in the order the faces first use each
+     vertex, and changes the indices to match, so the vertices are read from
+     memory in order. vertices nothing uses go at the end. baked colours
+     move with their vertices
+   inputs: an alloced object that has been filled with all the data
+   output: false if there wasn't enough memory
+ */
+bool reorder_vertices(object *o){
+  unsigned char *new_colours = NULL;
+  vertex *new_vertices;
+  int *remap, *indices;
+  int i, j, next = 0;
+  face *f;
+
+  if(o == NULL) return false;
+  if(o->n_vertices == 0) return true;
+
+  remap = (int *) malloc(sizeof(int) * o->n_vertices);
+  new_vertices = alloc_vertex_array(o->mem,o->n_vertices);
+  if(o->colours != NULL)
+    new_colours = (unsigned char *) arena_alloc(o->mem,4 * o->n_vertices);
+  if(remap == NULL || new_vertices == NULL ||
+     (o->colours != NULL && new_colours == NULL)) {
+    free(remap);
+    return false;
+  }
+
+  for(i = 0; i < o->n_vertices; i++)
+    remap[i] = -1;
+
+  for(i = 0; i < o->n_faces; i++){
+    f = o->faces + i;
+    indices = FACE_INDICES(o,f);
+    for(j = 0; j < f->n_vertices; j++)
+      if(indices[j] >= 0 && indices[j] < o->n_vertices &&
+         remap[indices[j]] < 0)
+        remap[indices[j]] = next++;
+  }
+
+  for(i = 0; i < o->n_vertices; i++){
+    if(remap[i] < 0)
+      remap[i] = next++;
+    new_vertices[remap[i]] = o->vertices[i];
+    if(new_colours != NULL)
+      memcpy(new_colours + 4 * remap[i],o->colours + 4 * i,4);
+  }
+
+  for(i = 0; i < o->n_faces; i++){
+    f = o->faces + i;
+    indices = FACE_INDICES(o,f);
+    for(j = 0; j < f->n_vertices; j++)
+      if(indices[j] >= 0 && indices[j] < o->n_vertices)
+        indices[j] = remap[indices[j]];
+  }
+
+  /* the old array stays in the arena (or cache) until the object is freed */
+  o->vertices = new_vertices;
+  if(new_colours != NULL)
+    o->colours = new_colours;
+
+  free(remap);
+
+  return true;
+}
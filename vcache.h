@@ -0,0 +1,23 @@
+/********************
+ * FILE: vcache.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for vcache.c. Contains the prototypes for the interface
+ *     functions
+ */
+
+#ifndef _CB_VCACHE_H
+#define _CB_VCACHE_H
+
+#include "common.h"
+
+/* the size of the post transform cache we optimise for and measure with */
+#define VCACHE_SIZE 32
+
+/* interface function prototypes */
+float acmr(object *);
+bool reorder_triangles(object *);
+bool reorder_vertices(object *);
+#endif /* !_CB_VCACHE_H */
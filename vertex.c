@@ -10,17 +10,16 @@
 
 #include <math.h> /*for sqrt*/
 #include <stdio.h> /*for printf*/
-#include <stdlib.h> /*for malloc*/
-
+#include "arena.h"
 #include "vertex.h"
 
 
 /* alloc_vertex_array():
    description: allocates an array of vertecies
-   inputs: size of array
+   inputs: the arena to allocate from, size of array
    output: pointer to alloced memory or NULL */
-vertex *alloc_vertex_array(int size){
-  return (vertex *) malloc(sizeof(vertex) * size);
+vertex *alloc_vertex_array(arena *a,int size){
+  return (vertex *) arena_alloc(a,sizeof(vertex) * size);
 }
 
 /* normalize_normal():
@@ -11,6 +11,8 @@
 #ifndef _CB_VERTEX_H
 #define _CB_VERTEX_H
 
+#include "arena.h"
+
 /* vertex struct. stores vertex information
 
  WARNING!!! - CHANGING the ORDER or TYPE, or ADDING new fields WILL BREAK the
@@ -30,8 +32,23 @@ typedef struct vertex_t{
 
 } vertex;
 
+/* a vertex squashed into 12 bytes. the position is a fraction of the size
+   of the model, between -32767 and 32767, and the normal is between -127
+   and 127, which GL scales back to -1 to 1 */
+typedef struct qvertex_t{
+  short x;
+  short y;
+  short z;
+  short pad;
+
+  signed char normX;
+  signed char normY;
+  signed char normZ;
+  signed char pad2;
+} qvertex;
+
 /* interface function prototypes */
-vertex *alloc_vertex_array(int);
+vertex *alloc_vertex_array(arena *,int);
 void normalize_normal(vertex *);
 void print_vertex(vertex);
 #endif /* !_CB_VERTEX_H */
@@ -0,0 +1,185 @@
+/********************
+ * FILE: weld.c
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Functions for welding together vertices that are in the same place
+ *     and have the same normal. Lots of exported models repeat every vertex
+ *     for every face that uses it. The vertices are dropped into a hash of
+ *     a grid over the model, so only vertices in neighbouring cells ever
+ *     need comparing.
+ */
+
+#include <stdlib.h> /*for malloc*/
+#include <math.h> /*for floor*/
+
+#include "common.h"
+#include "arena.h"
+#include "face.h"
+#include "vertex.h"
+#include "object.h"
+#include "weld.h"
+
+/* the smallest grid cell, as a fraction of the size of the model. stops the
+   cell coordinates getting silly when epsilon is tiny */
+#define MIN_CELL 0.00001f
+
+/* the spatial hash. head has a chain of the welded vertices in each slot,
+   linked together through next */
+typedef struct {
+  int *head;
+  int *next;
+  unsigned int size;
+  float cell;
+} grid;
+
+
+/* cell_of():
+   description: the grid cell a coordinate is in
+ */
+static long long cell_of(grid *g, float x){
+  return (long long) floor(x / g->cell);
+}
+
+
+/* cell_hash():
+   description: the slot for a grid cell
+ */
+static unsigned int cell_hash(grid *g, long long x, long long y, long long z){
+  unsigned long long h;
+
+  h = (unsigned long long) x * 73856093ULL ^
+      (unsigned long long) y * 19349663ULL ^
+      (unsigned long long) z * 83492791ULL;
+
+  return (unsigned int) (h ^ (h >> 32)) & (g->size - 1);
+}
+
+
+/* close_to():
+   description: true if two vertices are near enough to weld
+ */
+static bool close_to(vertex *a, vertex *b, float epsilon){
+  return fabsf(a->x - b->x) <= epsilon &&
+         fabsf(a->y - b->y) <= epsilon &&
+         fabsf(a->z - b->z) <= epsilon &&
+         fabsf(a->normX - b->normX) <= WELD_NORMAL_EPSILON &&
+         fabsf(a->normY - b->normY) <= WELD_NORMAL_EPSILON &&
+         fabsf(a->normZ - b->normZ) <= WELD_NORMAL_EPSILON ? true : false;
+}
+
+
+/* find_weld():
+   description: looks through the cells around a vertex for a welded vertex
+                close enough to it. the cells are at least epsilon wide, so
+                only the 27 around it need looking at
+   inputs: the grid, the welded vertices, the vertex, epsilon
+   output: the welded vertex it matches, or -1
+ */
+static int find_weld(grid *g, vertex *welded, vertex *v, float epsilon){
+  long long x = cell_of(g,v->x), y = cell_of(g,v->y), z = cell_of(g,v->z);
+  int dx, dy, dz, i;
+
+  for(dx = -1; dx <= 1; dx++)
+    for(dy = -1; dy <= 1; dy++)
+      for(dz = -1; dz <= 1; dz++)
+        for(i = g->head[cell_hash(g,x + dx,y + dy,z + dz)]; i >= 0;
+            i = g->next[i])
+          if(close_to(welded + i,v,epsilon))
+            return i;
+
+  return -1;
+}
+
+
+/* weld_vertices():
+   description: merges together vertices whose positions are within epsilon
+     of each other and whose normals are (almost) the same, and changes the
+     face indices to match. the first of each group is the one kept. the new
+     vertex array comes from the object's arena, the old one stays there (or
+     in the cache) until the object is freed
+   inputs: an alloced object that has been filled with all the data, how far
+           apart vertices can be in each axis and still be welded
+   output: the number of vertices the object now has
+ */
+int weld_vertices(object *o, float epsilon){
+  vertex *welded, *v;
+  int *remap, *indices;
+  int i, j, n = 0;
+  float min[3], max[3], size;
+  unsigned int slot;
+  grid g;
+
+  if(o == NULL || o->n_vertices == 0) return 0;
+  if(epsilon < 0) epsilon = 0;
+
+  /* make the cells at least epsilon big, but not so small they overflow */
+  min[0] = max[0] = o->vertices[0].x;
+  min[1] = max[1] = o->vertices[0].y;
+  min[2] = max[2] = o->vertices[0].z;
+  for(i = 1; i < o->n_vertices; i++){
+    v = o->vertices + i;
+    if(v->x < min[0]) min[0] = v->x;
+    if(v->x > max[0]) max[0] = v->x;
+    if(v->y < min[1]) min[1] = v->y;
+    if(v->y > max[1]) max[1] = v->y;
+    if(v->z < min[2]) min[2] = v->z;
+    if(v->z > max[2]) max[2] = v->z;
+  }
+
+  size = max[0] - min[0];
+  if(max[1] - min[1] > size) size = max[1] - min[1];
+  if(max[2] - min[2] > size) size = max[2] - min[2];
+
+  g.cell = size * MIN_CELL;
+  if(g.cell < epsilon) g.cell = epsilon;
+  if(g.cell <= 0) g.cell = 1;
+
+  for(g.size = 2; g.size < 2 * (unsigned int) o->n_vertices; g.size *= 2);
+
+  g.head = (int *) malloc(sizeof(int) * g.size);
+  g.next = (int *) malloc(sizeof(int) * o->n_vertices);
+  remap = (int *) malloc(sizeof(int) * o->n_vertices);
+  welded = alloc_vertex_array(o->mem,o->n_vertices);
+
+  if(g.head == NULL || g.next == NULL || remap == NULL || welded == NULL) {
+    n = o->n_vertices;
+    goto out;
+  }
+
+  for(slot = 0; slot < g.size; slot++)
+    g.head[slot] = -1;
+
+  for(i = 0; i < o->n_vertices; i++){
+    v = o->vertices + i;
+
+    if((j = find_weld(&g,welded,v,epsilon)) < 0) {
+      /* a new one */
+      j = n++;
+      welded[j] = *v;
+      slot = cell_hash(&g,cell_of(&g,v->x),cell_of(&g,v->y),cell_of(&g,v->z));
+      g.next[j] = g.head[slot];
+      g.head[slot] = j;
+    }
+
+    remap[i] = j;
+  }
+
+  for(i = 0; i < o->n_faces; i++){
+    indices = FACE_INDICES(o,o->faces + i);
+    for(j = 0; j < o->faces[i].n_vertices; j++)
+      if(indices[j] >= 0 && indices[j] < o->n_vertices)
+        indices[j] = remap[indices[j]];
+  }
+
+  o->vertices = welded;
+  o->n_vertices = o->filled_vertices = n;
+
+out:
+  free(g.head);
+  free(g.next);
+  free(remap);
+
+  return n;
+}
@@ -0,0 +1,21 @@
+/********************
+ * FILE: weld.h
+ * CREATION DATE: 17-10-2026
+ * MODIFICATION DATE: 17-10-2026
+ * AUTHOR: Caleb Brown
+ * DESCRIPTION:
+ *     Header file for weld.c. Contains the prototypes for the interface
+ *     functions
+ */
+
+#ifndef _CB_WELD_H
+#define _CB_WELD_H
+
+#include "common.h"
+
+/* how far apart the normals of two vertices can be and still be welded */
+#define WELD_NORMAL_EPSILON 0.0001f
+
+/* interface function prototypes */
+int weld_vertices(object *,float);
+#endif /* !_CB_WELD_H */